@@ -0,0 +1,112 @@
+#include "background_hint.h"
+#include "heuristic.h"
+
+using namespace std;
+
+TBackgroundHint::TBackgroundHint(int threads, size_t table_mb)
+        : service(threads, table_mb)
+        , cancel_flag(false)
+        , worker([this] { Loop(); }) {
+}
+
+TBackgroundHint::~TBackgroundHint() {
+    {
+        lock_guard<mutex> guard(lock);
+        stop_flag = true;
+        cancel_flag = true;
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+void TBackgroundHint::Request(const TBoard &board, const THintSettings &settings) {
+    {
+        lock_guard<mutex> guard(lock);
+        if (requested && *requested == board) {
+            return;
+        }
+        requested = board;
+        requested_settings = settings;
+        pending_flag = true;
+        cancel_flag = true; // перебор проверяет флаг раз в 256 узлов, поэтому останавливается за доли миллисекунды
+    }
+    wake.notify_one();
+}
+
+void TBackgroundHint::Cancel() {
+    lock_guard<mutex> guard(lock);
+    requested.reset();
+    pending_flag = false;
+    cancel_flag = true;
+}
+
+optional<THint> TBackgroundHint::GetCached(const TBoard &board) const {
+    lock_guard<mutex> guard(lock);
+    if (cached_board && *cached_board == board) {
+        return cached;
+    }
+    return nullopt;
+}
+
+THint TBackgroundHint::GetHintNow(const TBoard &board) const {
+    if (auto hint = GetCached(board)) {
+        return *hint;
+    }
+
+    // четыре оценки поля - микросекунды, отрисовку это не задерживает
+    THint hint;
+    float best = 0;
+    for (int turn = 0; turn < 4; turn++) {
+        const TBoard moved = TEngine::MoveBoard(board, static_cast<ETurnDirection>(turn));
+        if (moved == board) {
+            continue;
+        }
+        const float value = EvaluateBoard(moved);
+        if (!hint.found_flag || value > best) {
+            hint.found_flag = true;
+            hint.best_move = static_cast<ETurnDirection>(turn);
+            best = value;
+        }
+    }
+    return hint;
+}
+
+void TBackgroundHint::Publish(const TBoard &board, const THint &hint, bool final_flag) {
+    // вызывается без мьютекса; ответ на позицию, которую уже сменили, не нужен
+    lock_guard<mutex> guard(lock);
+    if (cancel_flag) {
+        return;
+    }
+    cached_board = board;
+    cached = hint;
+    cached_final_flag = final_flag;
+}
+
+void TBackgroundHint::Loop() {
+    unique_lock<mutex> guard(lock);
+
+    while (true) {
+        wake.wait(guard, [this] { return stop_flag || pending_flag; });
+        if (stop_flag) {
+            return;
+        }
+
+        const TBoard board = *requested;
+        const THintSettings settings = requested_settings;
+        pending_flag = false;
+        // флаг сбрасывается под мьютексом: запрос, пришедший после этого, прервёт уже новый перебор
+        cancel_flag = false;
+
+        if (cached_final_flag && cached_board && *cached_board == board) {
+            continue;
+        }
+
+        guard.unlock();
+        const THint hint = service.GetHint(board, settings, &cancel_flag, [this, &board](const THint &progress) {
+            Publish(board, progress, false);
+        });
+        // у прерванного перебора остаются только досчитанные глубины, опубликованные по ходу
+        Publish(board, hint, true);
+        guard.lock();
+    }
+}
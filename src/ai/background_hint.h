@@ -0,0 +1,56 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <optional>
+#include <thread>
+
+#include <ai/hint_service.h>
+
+// TBackgroundHint - подсказка, которая считается заранее, пока игрок думает
+// Request отдаёт позицию фоновому потоку и сразу возвращается; новая позиция прерывает старый перебор
+// через cancel_flag, и недосчитанная глубина прерванного перебора выбрасывается
+// каждая досчитанная глубина сразу публикуется для своей позиции, и GetCached отдаёт последнюю
+// без ожидания перебора - мьютекс держится только на время копирования
+
+class TBackgroundHint {
+    public:
+        explicit TBackgroundHint(int threads = 0, size_t table_mb = TRANSPOSITION_DEFAULT_MB);
+        ~TBackgroundHint();
+
+        TBackgroundHint(const TBackgroundHint &) = delete;
+        TBackgroundHint &operator=(const TBackgroundHint &) = delete;
+
+        // повторный запрос той же позиции ничего не перезапускает
+        void Request(const TBoard &board, const THintSettings &settings);
+        // прерывает перебор и забывает запрошенную позицию, например после конца игры
+        void Cancel();
+
+        // ответ самой глубокой досчитанной глубины для board; nullopt, пока не досчитана первая
+        std::optional<THint> GetCached(const TBoard &board) const;
+        // то же, а до первой глубины - лучший ход по оценке поля после него, без перебора; depth == 0
+        THint GetHintNow(const TBoard &board) const;
+
+    private:
+        void Loop();
+
+        THintService service;
+
+        mutable std::mutex lock;
+        std::condition_variable wake;
+
+        std::optional<TBoard> requested; // позиция, которую считаем или посчитаем следующей
+        THintSettings requested_settings;
+        bool pending_flag = false; // requested ещё не взята потоком
+        bool stop_flag = false;
+        std::atomic<bool> cancel_flag;
+
+        std::optional<TBoard> cached_board;
+        THint cached;
+        bool cached_final_flag = false; // перебор cached_board закончен, повторять его незачем
+
+        void Publish(const TBoard &board, const THint &hint, bool final_flag);
+
+        std::thread worker; // последним: запускается, когда остальные поля готовы
+};
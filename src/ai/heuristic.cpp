@@ -0,0 +1,32 @@
+#include <algorithm>
+
+#include "heuristic.h"
+
+using namespace std;
+
+static constexpr THeuristicTable MakeHeuristicTable() {
+    THeuristicTable table = {};
+
+    for (size_t row = 0; row < table.size(); row++) {
+        table[row] = MakeRowHeuristic(row);
+    }
+
+    return table;
+}
+
+// как и таблицы ходов, считается при компиляции
+constexpr THeuristicTable HEURISTIC_ROWS = MakeHeuristicTable();
+
+static constexpr float MakeLostValue() {
+    float min_row = 0;
+    for (float value : HEURISTIC_ROWS) {
+        min_row = min(min_row, value);
+    }
+
+    // поле - 4 строки и 4 столбца; запас вдвое, чтобы округление float не сравняло проигрыш с худшим живым полем
+    return 16 * min_row - 1;
+}
+
+constexpr float HEURISTIC_LOST_VALUE = MakeLostValue();
+
+static_assert(HEURISTIC_ROWS[0] == HEURISTIC_LOST_PENALTY + 4 * HEURISTIC_EMPTY_WEIGHT, "heuristic table must be built at compile time");
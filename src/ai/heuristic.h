@@ -0,0 +1,94 @@
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <engine/board.h>
+#include <engine/tables.h>
+
+// эвристическая оценка позиции для перебора: сумма оценок всех строк и всех столбцов
+// оценка строки - пустые клетки и возможные объединения в плюс, немонотонность и крупные тайлы не в углу в минус
+
+enum EHeuristicSettings {
+    HEURISTIC_LOST_PENALTY = 200000, // прибавка к каждой строке; крупные тайлы не по порядку всё равно уводят оценку ниже нуля
+    HEURISTIC_EMPTY_WEIGHT = 270,
+    HEURISTIC_MERGES_WEIGHT = 700,
+    HEURISTIC_MONOTONICITY_WEIGHT = 47,
+    HEURISTIC_SUM_WEIGHT = 11
+};
+
+typedef std::array<float, ROW_COUNT> THeuristicTable;
+
+extern const THeuristicTable HEURISTIC_ROWS;
+
+// оценка проигранной позиции: строго меньше оценки любого живого поля
+extern const float HEURISTIC_LOST_VALUE;
+
+constexpr double HeuristicSqrt(double x) {
+    // метод Ньютона; std::sqrt не constexpr
+    double result = x > 1 ? x : 1;
+    for (int i = 0; i < 32; i++) {
+        result = (result + x / result) / 2;
+    }
+    return result;
+}
+
+constexpr float MakeRowHeuristic(uint32_t row) {
+    int ranks[4] = {};
+    for (int i = 0; i < 4; i++) {
+        ranks[i] = (row >> (4 * i)) & 0xF;
+    }
+
+    double sum = 0;
+    int empty = 0;
+    int merges = 0;
+
+    int previous = 0;
+    int counter = 0;
+    for (int rank : ranks) {
+        sum += rank * rank * rank * HeuristicSqrt(rank); // rank^3.5
+        if (rank == 0) {
+            empty++;
+        } else {
+            if (previous == rank) {
+                counter++;
+            } else if (counter > 0) {
+                merges += 1 + counter;
+                counter = 0;
+            }
+            previous = rank;
+        }
+    }
+    if (counter > 0) {
+        merges += 1 + counter;
+    }
+
+    // немонотонность: меньшая из сумм "подъёмов" влево и вправо, в четвёртой степени показателя
+    double monotonicity_left = 0;
+    double monotonicity_right = 0;
+    for (int i = 1; i < 4; i++) {
+        const double a = double(ranks[i - 1]) * ranks[i - 1] * ranks[i - 1] * ranks[i - 1];
+        const double b = double(ranks[i]) * ranks[i] * ranks[i] * ranks[i];
+        if (ranks[i - 1] > ranks[i]) {
+            monotonicity_left += a - b;
+        } else {
+            monotonicity_right += b - a;
+        }
+    }
+
+    return HEURISTIC_LOST_PENALTY
+         + HEURISTIC_EMPTY_WEIGHT * empty
+         + HEURISTIC_MERGES_WEIGHT * merges
+         - HEURISTIC_MONOTONICITY_WEIGHT * (monotonicity_left < monotonicity_right ? monotonicity_left : monotonicity_right)
+         - HEURISTIC_SUM_WEIGHT * sum;
+}
+
+inline float EvaluateBoard(const TBoard &board) {
+    const TBoard transposed = board.Transpose();
+
+    float result = 0;
+    for (int i = 0; i < 4; i++) {
+        result += HEURISTIC_ROWS[board.GetRow(i)] + HEURISTIC_ROWS[transposed.GetRow(i)];
+    }
+    return result;
+}
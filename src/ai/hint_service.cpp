@@ -0,0 +1,122 @@
+#include "hint_service.h"
+
+using namespace std;
+
+// следующая глубина дороже предыдущей хотя бы во столько раз; пока измерена одна глубина, берётся это число
+static const double MIN_DEPTH_GROWTH = 4;
+
+THintService::THintService(int threads, size_t table_mb)
+        : own_pool(make_unique<TThreadPool>(threads))
+        , own_table(make_unique<TTranspositionTable>(table_mb))
+        , pool(*own_pool)
+        , table(*own_table)
+        , solver(pool, table) {
+}
+
+THintService::THintService(TThreadPool &shared_pool, TTranspositionTable &shared_table)
+        : pool(shared_pool)
+        , table(shared_table)
+        , solver(pool, table) {
+}
+
+TTranspositionTable &THintService::GetTable() {
+    return table;
+}
+
+THint THintService::GetHint(const TEngine &engine, const THintSettings &settings, const atomic<bool> *cancel_flag, const THintProgress &progress) {
+    if (engine.IsEnd()) {
+        return THint();
+    }
+    return GetHint(engine.GetBoard(), settings, cancel_flag, progress);
+}
+
+THint THintService::GetFallbackHint(const TBoard &board) {
+    // таблица без блокировок, её можно читать, пока другой вызов ищет
+    THint hint;
+    const int legal = TEngine::LegalMoves(board);
+    if (legal == 0) {
+        return hint;
+    }
+    hint.found_flag = true;
+
+    TTranspositionEntry entry;
+    if (table.Probe(board, ETranspositionNode::MOVE, entry) && entry.move_flag && (legal & (1 << static_cast<int>(entry.best_move)))) {
+        hint.best_move = entry.best_move;
+    } else {
+        hint.best_move = static_cast<ETurnDirection>(CountTrailingZeros(legal));
+    }
+    return hint;
+}
+
+THint THintService::GetHint(const TBoard &board, const THintSettings &settings, const atomic<bool> *cancel_flag, const THintProgress &progress) {
+    // срок считается до ожидания: время, проведённое в очереди за другим вызовом, входит в budget
+    const auto start = chrono::steady_clock::now();
+    const auto deadline = start + settings.budget;
+
+    unique_lock<timed_mutex> guard(lock, deadline);
+    if (!guard.owns_lock()) {
+        THint hint = GetFallbackHint(board);
+        const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+        hint.seconds = elapsed.count();
+        return hint;
+    }
+
+    TSolverBudget budget;
+    budget.probability_threshold = settings.probability_threshold;
+    budget.deadline = deadline;
+    budget.cancel_flag = cancel_flag;
+
+    THint hint;
+    double previous_seconds = 0;
+
+    for (int depth = 1; depth <= settings.max_depth; depth++) {
+        // глубину, которая по прошлым итерациям заведомо не успеет, не начинаем: время ушло бы впустую
+        if (!hint.iterations.empty()) {
+            const double last_seconds = hint.iterations.back().seconds;
+            const double growth = previous_seconds > 0 ? max(MIN_DEPTH_GROWTH, last_seconds / previous_seconds) : MIN_DEPTH_GROWTH;
+            const chrono::duration<double> remaining = deadline - chrono::steady_clock::now();
+            if (last_seconds * growth > remaining.count()) {
+                break;
+            }
+            previous_seconds = last_seconds;
+        }
+
+        budget.depth = depth;
+        const TSolverResult result = solver.BestMove(board, budget);
+
+        if (!result.found_flag) {
+            break; // ходов нет
+        }
+        hint.found_flag = true;
+
+        THintIteration iteration;
+        iteration.depth = depth;
+        iteration.seconds = result.seconds;
+        iteration.nodes = result.nodes;
+        iteration.complete_flag = result.complete_flag;
+        iteration.best_move = result.best_move;
+        hint.iterations.push_back(iteration);
+
+        if (result.complete_flag) {
+            hint.best_move = result.best_move;
+            hint.depth = depth;
+            if (progress) {
+                const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+                hint.seconds = elapsed.count();
+                progress(hint);
+            }
+            continue;
+        }
+
+        // прерванная итерация: её ходы сравнимы между собой, и если прошлый лучший ход досчитан,
+        // лучший из досчитанных не хуже него; иначе остаётся ответ прошлой глубины
+        if (hint.depth == 0 || result.complete_moves[static_cast<int>(hint.best_move)]) {
+            hint.best_move = result.best_move;
+        }
+        break;
+    }
+
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    hint.seconds = elapsed.count();
+    return hint;
+}
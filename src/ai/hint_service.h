@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <ai/parallel_solver.h>
+#include <ai/thread_pool.h>
+#include <ai/transposition.h>
+
+// THintService - подсказка хода за ограниченное время: итеративное углубление поверх TParallelSolver
+// глубины 1, 2, 3, ... ищутся по очереди до budget; ответ - лучший ход последней досчитанной глубины
+// таблица позиций общая для итераций и для подсказок подряд: лучший ход прошлой итерации ищется первым,
+// поэтому прерванная итерация часто успевает его досчитать и может уточнить ответ
+
+struct THintSettings {
+    std::chrono::microseconds budget = std::chrono::milliseconds(20);
+    int max_depth = 8;
+    float probability_threshold = 0.0001f;
+};
+
+struct THintIteration {
+    int depth = 0;
+    double seconds = 0;
+    uint64_t nodes = 0;
+    bool complete_flag = false;
+    ETurnDirection best_move = ETurnDirection::UP;
+};
+
+struct THint {
+    bool found_flag = false; // false, если ходов нет
+    ETurnDirection best_move = ETurnDirection::UP;
+    int depth = 0; // последняя досчитанная глубина, 0 - не досчитана ни одна
+    double seconds = 0;
+
+    std::vector<THintIteration> iterations; // время каждой глубины, для подбора budget
+};
+
+// вызывается после каждой досчитанной глубины с ответом на эту глубину, в потоке GetHint
+typedef std::function<void(const THint &)> THintProgress;
+
+class THintService {
+    public:
+        explicit THintService(int threads = 0, size_t table_mb = TRANSPOSITION_DEFAULT_MB);
+        // пул и таблица общие с другими сервисами, например по сервису на поток самоигры; не копируются
+        THintService(TThreadPool &shared_pool, TTranspositionTable &shared_table);
+
+        // возвращается не позже budget (с точностью до проверки времени в переборе) или сразу после cancel_flag
+        // одновременные вызовы выполняются по очереди; если предыдущий не закончился до budget,
+        // ответ без перебора: ход из таблицы, если он там есть, иначе первый возможный
+        THint GetHint(const TBoard &board, const THintSettings &settings, const std::atomic<bool> *cancel_flag = nullptr,
+                      const THintProgress &progress = THintProgress());
+        THint GetHint(const TEngine &engine, const THintSettings &settings, const std::atomic<bool> *cancel_flag = nullptr,
+                      const THintProgress &progress = THintProgress());
+
+        TTranspositionTable &GetTable();
+
+    private:
+        std::unique_ptr<TThreadPool> own_pool;
+        std::unique_ptr<TTranspositionTable> own_table;
+        TThreadPool &pool;
+        TTranspositionTable &table;
+        TParallelSolver solver;
+
+        std::timed_mutex lock;
+
+        THint GetFallbackHint(const TBoard &board);
+};
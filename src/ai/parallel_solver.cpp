@@ -0,0 +1,121 @@
+#include <atomic>
+
+#include "parallel_solver.h"
+
+using namespace std;
+
+TParallelSolver::TParallelSolver(TThreadPool &pool_arg, TTranspositionTable &table_arg)
+        : pool(pool_arg)
+        , table(table_arg)
+        , root_solver(table_arg) {
+    for (int i = 0; i < pool.GetThreadCount(); i++) {
+        solvers.push_back(make_unique<TSolver>(table));
+    }
+}
+
+TSolverResult TParallelSolver::BestMove(const TEngine &engine, const TSolverBudget &budget) {
+    if (engine.IsEnd()) {
+        return TSolverResult();
+    }
+    return BestMove(engine.GetBoard(), budget);
+}
+
+TSolverResult TParallelSolver::BestMove(const TBoard &board, const TSolverBudget &budget) {
+    // на глубине 1 слой случая - уже листья, делить нечего
+    if (budget.depth <= 1 || budget.probability_threshold > 1) {
+        return root_solver.BestMove(board, budget);
+    }
+
+    const auto start = chrono::steady_clock::now();
+    const TTranspositionStats stats_before = table.GetStats();
+
+    // оценки поддеревьев: для хода turn - по два на пустую клетку (тайл 2, тайл 4) в порядке клеток
+    array<vector<float>, 4> values;
+    array<vector<char>, 4> done;
+
+    atomic<uint64_t> nodes(0);
+    atomic<bool> stop(false);
+
+    TSolverResult result;
+    TTaskGroup group(pool);
+
+    // задачи лучшего прошлого хода ставятся первыми и первыми выполняются
+    for (ETurnDirection turn : root_solver.OrderMoves(board, budget)) {
+        const int i = static_cast<int>(turn);
+        const TBoard moved = TEngine::MoveBoard(board, turn);
+        if (moved == board) {
+            continue;
+        }
+
+        result.found_flag = true;
+        const uint64_t empty_cells = moved.GetEmptyCells();
+        const int count = PopCount(empty_cells);
+        values[i].resize(2 * count);
+        done[i].resize(2 * count);
+
+        int k = 0;
+        for (uint64_t cells = empty_cells; cells; cells &= cells - 1) {
+            const uint64_t cell = cells & -cells;
+
+            for (int four = 0; four < 2; four++, k++) {
+                const TBoard spawned(moved.GetRaw() | cell * static_cast<int>(four ? EEngineTileType::TILE_4 : EEngineTileType::TILE_2));
+                const float probability = (four ? TSolver::PROBABILITY_4 : TSolver::PROBABILITY_2) / count;
+
+                group.Run([&, i, k, spawned, probability]() {
+                    // задача, до которой очередь дошла после остановки, не начинается
+                    if (stop || (budget.cancel_flag && *budget.cancel_flag) || chrono::steady_clock::now() >= budget.deadline) {
+                        stop = true;
+                        return;
+                    }
+
+                    TSolver &solver = *solvers[pool.GetWorkerIndex()];
+                    const float value = solver.SearchMoveNode(spawned, 2, probability, budget);
+                    nodes.fetch_add(solver.GetNodeCount(), memory_order_relaxed);
+
+                    if (solver.IsStopped()) {
+                        stop = true;
+                    } else {
+                        values[i][k] = value;
+                        done[i][k] = true;
+                    }
+                });
+            }
+        }
+    }
+
+    group.Wait();
+
+    // сведение в том же порядке, что и в TSolver::ScoreChanceNode
+    array<bool, 4> complete = {};
+    for (int i = 0; i < 4; i++) {
+        if (values[i].empty()) {
+            continue;
+        }
+
+        float sum = 0;
+        bool complete_flag = true;
+        for (size_t k = 0; k < values[i].size(); k += 2) {
+            sum += TSolver::PROBABILITY_2 * values[i][k];
+            sum += TSolver::PROBABILITY_4 * values[i][k + 1];
+            complete_flag &= done[i][k] && done[i][k + 1];
+        }
+
+        result.values[i] = sum / (values[i].size() / 2);
+        complete[i] = complete_flag;
+    }
+
+    root_solver.FinishRoot(board, complete, stop, budget, result);
+
+    const TTranspositionStats stats_after = table.GetStats();
+    result.transposition_stats.probes = stats_after.probes - stats_before.probes;
+    result.transposition_stats.hits = stats_after.hits - stats_before.hits;
+    result.transposition_stats.collisions = stats_after.collisions - stats_before.collisions;
+    result.transposition_stats.stores = stats_after.stores - stats_before.stores;
+    result.transposition_stats.replacements = stats_after.replacements - stats_before.replacements;
+
+    // как в TSolver: плюс по узлу случая на каждый корневой ход
+    result.nodes = nodes + PopCount(TEngine::LegalMoves(board));
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
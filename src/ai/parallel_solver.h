@@ -0,0 +1,28 @@
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <ai/solver.h>
+#include <ai/thread_pool.h>
+#include <ai/transposition.h>
+
+// TParallelSolver - тот же expectimax, что TSolver, на пуле потоков
+// корень делится на задачи по корневым ходам и по первому слою случая: ход x клетка x тайл,
+// для поля с восемью пустыми клетками это до 64 независимых поддеревьев; таблица позиций общая для всех потоков
+// по deadline или cancel_flag из бюджета все задачи останавливаются сами, результат - как у TSolver
+
+class TParallelSolver {
+    public:
+        TParallelSolver(TThreadPool &pool, TTranspositionTable &table);
+
+        TSolverResult BestMove(const TEngine &engine, const TSolverBudget &budget);
+        TSolverResult BestMove(const TBoard &board, const TSolverBudget &budget);
+
+    private:
+        TThreadPool &pool;
+        TTranspositionTable &table;
+
+        std::vector<std::unique_ptr<TSolver>> solvers; // по решателю на поток пула
+        TSolver root_solver; // ищет, если делить нечего, и записывает корень
+};
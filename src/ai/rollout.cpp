@@ -0,0 +1,112 @@
+#include <atomic>
+
+#include "rollout.h"
+
+using namespace std;
+
+double TRolloutResult::GetRolloutsPerSecond() const {
+    return seconds > 0 ? total_rollouts / seconds : 0;
+}
+
+TRollout::TRollout(TThreadPool &pool_arg)
+        : pool(pool_arg) {
+    for (int i = 0; i < pool.GetThreadCount(); i++) {
+        engines.push_back(make_unique<TEngine>(i));
+    }
+}
+
+void TRollout::PlayRandomGame(TEngine &engine, TRandom &random, int max_depth) {
+    for (int depth = 0; !engine.IsEnd() && (max_depth == 0 || depth < max_depth); depth++) {
+        const int legal = engine.LegalMoves();
+        const int turn = SelectBit(legal, random.Below(PopCount(legal)));
+
+        engine.ApplyMove(static_cast<ETurnDirection>(turn));
+        engine.AfterTurn(random.Next());
+    }
+}
+
+TRolloutResult TRollout::Evaluate(const TEngine &engine, const TRolloutSettings &settings, TClock::time_point deadline) {
+    const auto start = TClock::now();
+
+    TRolloutResult result;
+    const int legal = engine.LegalMoves();
+    if (legal == 0) {
+        return result;
+    }
+
+    // случайные партии идут до проигрыша, даже если выигрышный тайл уже есть
+    TEngineState root = engine.Snapshot();
+    root.keep_playing_flag = true;
+
+    // суммы сводятся без блокировок: каждая задача считает у себя и один раз прибавляет
+    array<atomic<uint64_t>, 4> score_sums = {};
+    array<atomic<uint64_t>, 4> counts = {};
+    atomic<bool> deadline_flag(false);
+
+    const int chunk_size = max(1, settings.chunk_size);
+    const int chunks = (settings.rollouts_per_move + chunk_size - 1) / chunk_size;
+
+    TTaskGroup group(pool);
+
+    // задачи разных ходов чередуются, чтобы при остановке по времени ходы были оценены поровну
+    for (int chunk = 0; chunk < chunks; chunk++) {
+        for (int turn = 0; turn < 4; turn++) {
+            if (!(legal & (1 << turn))) {
+                continue;
+            }
+
+            const int count = min(chunk_size, settings.rollouts_per_move - chunk * chunk_size);
+            const uint64_t seed = settings.seed + 4 * uint64_t(chunk) + turn;
+
+            group.Run([&, turn, count, seed]() {
+                TEngine &scratch = *engines[pool.GetWorkerIndex()];
+                TRandom random(seed);
+
+                uint64_t score_sum = 0;
+                uint64_t played = 0;
+                for (int i = 0; i < count; i++) {
+                    if (TClock::now() >= deadline) {
+                        deadline_flag = true;
+                        break;
+                    }
+
+                    scratch.Restore(root);
+                    scratch.ApplyMove(static_cast<ETurnDirection>(turn));
+                    scratch.AfterTurn(random.Next());
+                    PlayRandomGame(scratch, random, settings.max_depth);
+
+                    score_sum += scratch.GetScore();
+                    played++;
+                }
+
+                score_sums[turn].fetch_add(score_sum, memory_order_relaxed);
+                counts[turn].fetch_add(played, memory_order_relaxed);
+            });
+        }
+    }
+
+    group.Wait();
+
+    for (int turn = 0; turn < 4; turn++) {
+        result.rollout_counts[turn] = counts[turn];
+        result.total_rollouts += counts[turn];
+        if (counts[turn] > 0) {
+            result.mean_scores[turn] = double(score_sums[turn]) / counts[turn];
+            if (!result.found_flag || result.mean_scores[turn] > result.mean_scores[static_cast<int>(result.best_move)]) {
+                result.found_flag = true;
+                result.best_move = static_cast<ETurnDirection>(turn);
+            }
+        }
+    }
+
+    // если время вышло до первой партии, ход всё равно нужен: первый из возможных
+    if (!result.found_flag) {
+        result.found_flag = true;
+        result.best_move = static_cast<ETurnDirection>(CountTrailingZeros(legal));
+    }
+
+    result.deadline_flag = deadline_flag;
+    const chrono::duration<double> elapsed = TClock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+#include <engine/engine.h>
+#include <ai/thread_pool.h>
+
+// TRollout - оценка ходов методом Монте-Карло: из каждого хода, меняющего поле,
+// играется много случайных партий до конца, лучший ход - с наибольшим средним итоговым счётом
+// партии нарезаны на задачи пула; у каждой задачи свой генератор (seed + номер задачи), поэтому
+// при одинаковом seed и без ограничения по времени результат не зависит от числа потоков
+
+struct TRolloutSettings {
+    int rollouts_per_move = 1000; // не больше стольких партий на ход, если раньше не наступит deadline
+    int chunk_size = 32; // партий в одной задаче пула
+    int max_depth = 0; // ходов в одной случайной партии, 0 - до проигрыша
+    uint64_t seed = 1;
+};
+
+struct TRolloutResult {
+    bool found_flag = false; // false, если ходов нет
+    ETurnDirection best_move = ETurnDirection::UP;
+
+    // по индексу static_cast<int>(ETurnDirection)
+    std::array<uint64_t, 4> rollout_counts = {};
+    std::array<double, 4> mean_scores = {};
+
+    uint64_t total_rollouts = 0;
+    double seconds = 0;
+    bool deadline_flag = false; // остановлено по времени, партий меньше заказанного
+
+    double GetRolloutsPerSecond() const;
+};
+
+class TRollout {
+    public:
+        typedef std::chrono::steady_clock TClock;
+
+        explicit TRollout(TThreadPool &pool);
+
+        TRolloutResult Evaluate(const TEngine &engine, const TRolloutSettings &settings,
+                                TClock::time_point deadline = TClock::time_point::max());
+
+        // доигрывает партию случайными ходами; новые тайлы берутся из random, а не из генератора движка
+        static void PlayRandomGame(TEngine &engine, TRandom &random, int max_depth);
+
+    private:
+        TThreadPool &pool;
+
+        // движок на каждый поток пула: восстанавливается из снимка без выделения памяти на каждую партию
+        std::vector<std::unique_ptr<TEngine>> engines;
+};
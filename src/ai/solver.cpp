@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <chrono>
+
+#include <engine/symmetry.h>
+
+#include "heuristic.h"
+#include "solver.h"
+
+using namespace std;
+
+static const ETurnDirection ALL_TURNS[] = {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT};
+
+// время и отмена проверяются раз в STOP_CHECK_MASK + 1 узлов
+static const uint64_t STOP_CHECK_MASK = 0xFF;
+
+TSolver::TSolver()
+        : own_table(std::make_unique<TTranspositionTable>())
+        , table(own_table.get()) {
+}
+
+TSolver::TSolver(TTranspositionTable &shared_table)
+        : table(&shared_table) {
+}
+
+TTranspositionTable &TSolver::GetTable() {
+    return *table;
+}
+
+TSolverResult TSolver::BestMove(const TEngine &engine, const TSolverBudget &budget) {
+    if (engine.IsEnd()) {
+        return TSolverResult();
+    }
+    return BestMove(engine.GetBoard(), budget);
+}
+
+TSolverResult TSolver::BestMove(const TBoard &board, const TSolverBudget &budget) {
+    const auto start = chrono::steady_clock::now();
+
+    settings = budget;
+    nodes = 0;
+    stopped_flag = false;
+
+    const TTranspositionStats stats_before = table->GetStats();
+
+    TSolverResult result;
+    array<bool, 4> complete = {};
+    for (ETurnDirection turn : OrderMoves(board, budget)) {
+        const TBoard moved = TEngine::MoveBoard(board, turn);
+        if (moved == board) {
+            continue;
+        }
+
+        result.found_flag = true;
+        result.values[static_cast<int>(turn)] = ScoreChanceNode(moved, 1, 1.0f);
+        if (stopped_flag) {
+            break;
+        }
+        complete[static_cast<int>(turn)] = true;
+    }
+
+    FinishRoot(board, complete, stopped_flag, budget, result);
+
+    const TTranspositionStats stats_after = table->GetStats();
+    result.transposition_stats.probes = stats_after.probes - stats_before.probes;
+    result.transposition_stats.hits = stats_after.hits - stats_before.hits;
+    result.transposition_stats.collisions = stats_after.collisions - stats_before.collisions;
+    result.transposition_stats.stores = stats_after.stores - stats_before.stores;
+    result.transposition_stats.replacements = stats_after.replacements - stats_before.replacements;
+
+    result.nodes = nodes;
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    result.seconds = elapsed.count();
+    return result;
+}
+
+void TSolver::FinishRoot(const TBoard &board, const array<bool, 4> &complete, bool stop, const TSolverBudget &budget, TSolverResult &result) {
+    // result.found_flag и values уже заполнены; оценки недосчитанных ходов обнуляются
+    settings = budget;
+    bool chosen_flag = false;
+    for (ETurnDirection turn : ALL_TURNS) {
+        const int i = static_cast<int>(turn);
+        if (!complete[i]) {
+            result.values[i] = 0;
+        } else if (!chosen_flag || result.values[i] > result.values[static_cast<int>(result.best_move)]) {
+            chosen_flag = true;
+            result.best_move = turn;
+        }
+    }
+
+    // не досчитан ни один ход: любой возможный лучше, чем никакого
+    if (result.found_flag && !chosen_flag) {
+        result.best_move = static_cast<ETurnDirection>(CountTrailingZeros(TEngine::LegalMoves(board)));
+    }
+    result.complete_flag = result.found_flag && !stop;
+    result.complete_moves = complete;
+
+    if (result.complete_flag) {
+        TTranspositionEntry entry;
+        entry.value = result.values[static_cast<int>(result.best_move)];
+        entry.depth = settings.depth;
+        entry.move_flag = true;
+        entry.best_move = result.best_move;
+        Store(board, ETranspositionNode::MOVE, entry);
+    }
+}
+
+array<ETurnDirection, 4> TSolver::OrderMoves(const TBoard &board, const TSolverBudget &budget) {
+    // лучший ход прошлого поиска этой позиции - первым: если поиск прервут, он уже будет досчитан
+    settings = budget;
+
+    array<ETurnDirection, 4> result = {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT};
+
+    TTranspositionEntry entry;
+    if (Probe(board, ETranspositionNode::MOVE, entry) && entry.move_flag) {
+        rotate(result.begin(), result.begin() + static_cast<int>(entry.best_move), result.begin() + static_cast<int>(entry.best_move) + 1);
+    }
+    return result;
+}
+
+float TSolver::SearchMoveNode(const TBoard &board, int depth, float probability, const TSolverBudget &budget) {
+    settings = budget;
+    nodes = 0;
+    stopped_flag = false;
+
+    return ScoreMoveNode(board, depth, probability);
+}
+
+uint64_t TSolver::GetNodeCount() const {
+    return nodes;
+}
+
+bool TSolver::IsStopped() const {
+    return stopped_flag;
+}
+
+bool TSolver::CheckStop() {
+    // вызывается раз в несколько сотен узлов: часы дороже, чем сам узел
+    if ((settings.cancel_flag && settings.cancel_flag->load(memory_order_relaxed))
+            || chrono::steady_clock::now() >= settings.deadline) {
+        stopped_flag = true;
+    }
+    return stopped_flag;
+}
+
+bool TSolver::Probe(const TBoard &board, ETranspositionNode node, TTranspositionEntry &entry) {
+    if (!settings.symmetry_flag) {
+        return table->Probe(board, node, entry);
+    }
+
+    // в таблице лежит каноническое поле, лучший ход - в его системе координат
+    const auto canonical = Canonicalize(board);
+    if (!table->Probe(canonical.first, node, entry)) {
+        return false;
+    }
+    entry.best_move = ApplySymmetry(entry.best_move, InverseSymmetry(canonical.second));
+    return true;
+}
+
+void TSolver::Store(const TBoard &board, ETranspositionNode node, TTranspositionEntry entry) {
+    if (!settings.symmetry_flag) {
+        table->Store(board, node, entry);
+        return;
+    }
+
+    const auto canonical = Canonicalize(board);
+    entry.best_move = ApplySymmetry(entry.best_move, canonical.second);
+    table->Store(canonical.first, node, entry);
+}
+
+float TSolver::ScoreMoveNode(const TBoard &board, int depth, float probability) {
+    // ход игрока: лучший из ходов, меняющих поле; без ходов - проигрыш, оценка HEURISTIC_LOST_VALUE
+    if (stopped_flag || ((++nodes & STOP_CHECK_MASK) == 0 && CheckStop())) {
+        return 0;
+    }
+
+    // сколько ходов игрока осталось просмотреть, считая этот
+    const int remaining = settings.depth - depth + 1;
+
+    TTranspositionEntry entry;
+    if (Probe(board, ETranspositionNode::MOVE, entry) && entry.depth >= remaining) {
+        return entry.value;
+    }
+
+    entry = TTranspositionEntry();
+    entry.value = HEURISTIC_LOST_VALUE;
+    entry.depth = remaining;
+    for (ETurnDirection turn : ALL_TURNS) {
+        const TBoard moved = TEngine::MoveBoard(board, turn);
+        if (moved != board) {
+            const float value = ScoreChanceNode(moved, depth, probability);
+            if (!entry.move_flag || value > entry.value) {
+                entry.value = value;
+                entry.move_flag = true;
+                entry.best_move = turn;
+            }
+        }
+    }
+
+    if (stopped_flag) {
+        return 0;
+    }
+    Store(board, ETranspositionNode::MOVE, entry);
+    return entry.value;
+}
+
+float TSolver::ScoreChanceNode(const TBoard &board, int depth, float probability) {
+    // появление тайла: среднее по пустым клеткам; после хода, изменившего поле, пустая клетка есть всегда
+    if (stopped_flag || ((++nodes & STOP_CHECK_MASK) == 0 && CheckStop())) {
+        return 0;
+    }
+
+    if (depth >= settings.depth || probability < settings.probability_threshold) {
+        return EvaluateBoard(board);
+    }
+
+    const int remaining = settings.depth - depth;
+
+    TTranspositionEntry entry;
+    if (Probe(board, ETranspositionNode::CHANCE, entry) && entry.depth >= remaining) {
+        return entry.value;
+    }
+
+    // младший бит каждой пустой тетрады; умноженный на номер тайла, он ставит этот тайл в клетку
+    uint64_t empty_cells = board.GetEmptyCells();
+    const int count = PopCount(empty_cells);
+
+    const float probability_2 = probability * PROBABILITY_2 / count;
+    const float probability_4 = probability * PROBABILITY_4 / count;
+
+    float sum = 0;
+    for (; empty_cells; empty_cells &= empty_cells - 1) {
+        const uint64_t cell = empty_cells & -empty_cells;
+        const TBoard with_2(board.GetRaw() | cell * static_cast<int>(EEngineTileType::TILE_2));
+        const TBoard with_4(board.GetRaw() | cell * static_cast<int>(EEngineTileType::TILE_4));
+
+        sum += PROBABILITY_2 * ScoreMoveNode(with_2, depth + 1, probability_2);
+        sum += PROBABILITY_4 * ScoreMoveNode(with_4, depth + 1, probability_4);
+    }
+
+    if (stopped_flag) {
+        return 0;
+    }
+
+    entry = TTranspositionEntry();
+    entry.value = sum / count;
+    entry.depth = remaining;
+    Store(board, ETranspositionNode::CHANCE, entry);
+
+    return entry.value;
+}
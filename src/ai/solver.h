@@ -0,0 +1,83 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+
+#include <engine/engine.h>
+#include <ai/transposition.h>
+
+// TSolver - выбор хода перебором expectimax на поле 4x4
+// узлы хода - максимум по четырём направлениям, узлы случая - среднее по всем пустым клеткам и по тайлу
+// (2 с вероятностью 0.9, 4 с вероятностью 0.1, как в AddRandomTile); на глубине перебора - эвристика
+// ветви, вероятность попасть в которые ниже порога, не раскрываются
+// посчитанные узлы запоминаются в таблице позиций и переживают поиск: следующий ход часто приходит в те же поля
+// поиск останавливается сам по deadline или cancel_flag; недосчитанные узлы в таблицу не попадают
+
+struct TSolverBudget {
+    int depth = 3; // сколько ходов игрока просматривается, считая корневой
+    float probability_threshold = 0.0001f; // ветви случая с меньшей вероятностью оцениваются эвристикой
+    // симметричные поля - одна запись в таблице позиций: таблица нужна меньше, но каждое обращение дороже
+    bool symmetry_flag = false;
+
+    std::chrono::steady_clock::time_point deadline = std::chrono::steady_clock::time_point::max();
+    const std::atomic<bool> *cancel_flag = nullptr; // поиск прекращается, как только здесь true
+};
+
+struct TSolverResult {
+    bool found_flag = false; // false, если ходов нет
+    bool complete_flag = false; // все ходы досчитаны; иначе best_move - лучший из досчитанных или первый возможный
+    ETurnDirection best_move = ETurnDirection::UP;
+
+    std::array<float, 4> values = {}; // оценки ходов по индексу static_cast<int>(ETurnDirection), 0 - ход невозможен
+    std::array<bool, 4> complete_moves = {}; // какие оценки досчитаны
+    uint64_t nodes = 0; // узлов случая и хода, включая листья
+    double seconds = 0;
+
+    TTranspositionStats transposition_stats; // обращения к таблице за этот поиск, если таблицей пользуется только он
+};
+
+class TSolver {
+    public:
+        // вероятности тайлов, как в TBasicEngine::SpawnTile
+        static constexpr float PROBABILITY_2 = 0.9f;
+        static constexpr float PROBABILITY_4 = 0.1f;
+
+        TSolver(); // своя таблица на TRANSPOSITION_DEFAULT_MB
+        explicit TSolver(TTranspositionTable &shared_table); // таблица общая с другими решателями, не копируется
+
+        TSolverResult BestMove(const TEngine &engine, const TSolverBudget &budget);
+        TSolverResult BestMove(const TBoard &board, const TSolverBudget &budget);
+
+        // узел хода на глубине depth с вероятностью probability, например поддерево при разбиении корня по потокам
+        float SearchMoveNode(const TBoard &board, int depth, float probability, const TSolverBudget &budget);
+        uint64_t GetNodeCount() const; // узлов в последнем поиске
+
+        // все направления, лучший ход из таблицы (например, с прошлой итерации углубления) - первым
+        std::array<ETurnDirection, 4> OrderMoves(const TBoard &board, const TSolverBudget &budget);
+        bool IsStopped() const; // последний поиск прерван, его оценки не годятся
+
+        TTranspositionTable &GetTable();
+
+        // по оценкам корневых ходов в result.values: лучший ход среди досчитанных и, если досчитаны все, запись корня
+        // в таблицу; общее для одно- и многопоточного поиска
+        void FinishRoot(const TBoard &board, const std::array<bool, 4> &complete, bool stop, const TSolverBudget &budget, TSolverResult &result);
+
+    private:
+        std::unique_ptr<TTranspositionTable> own_table;
+        TTranspositionTable *table;
+
+        TSolverBudget settings;
+        uint64_t nodes = 0;
+        bool stopped_flag = false;
+
+        bool CheckStop();
+
+        bool Probe(const TBoard &board, ETranspositionNode node, TTranspositionEntry &entry);
+        void Store(const TBoard &board, ETranspositionNode node, TTranspositionEntry entry);
+
+        float ScoreMoveNode(const TBoard &board, int depth, float probability);
+        float ScoreChanceNode(const TBoard &board, int depth, float probability);
+};
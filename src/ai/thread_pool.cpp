@@ -0,0 +1,199 @@
+#include <utility>
+
+#include "thread_pool.h"
+
+using namespace std;
+
+// пул, к которому относится текущий поток, и номер потока в нём
+static thread_local const TThreadPool *current_pool = nullptr;
+static thread_local int current_index = -1;
+
+TThreadPool::TThreadPool(int thread_count)
+        : pending_count(0)
+        , next_queue(0)
+        , stop_flag(false) {
+    if (thread_count <= 0) {
+        thread_count = max(1u, thread::hardware_concurrency());
+    }
+
+    for (int i = 0; i < thread_count; i++) {
+        queues.push_back(make_unique<TQueue>());
+    }
+    for (int i = 0; i < thread_count; i++) {
+        threads.emplace_back(&TThreadPool::WorkerLoop, this, i);
+    }
+}
+
+TThreadPool::~TThreadPool() {
+    {
+        lock_guard<mutex> guard(sleep_lock);
+        stop_flag = true;
+    }
+    wake.notify_all();
+
+    for (thread &t : threads) {
+        t.join();
+    }
+}
+
+int TThreadPool::GetThreadCount() const {
+    return threads.size();
+}
+
+int TThreadPool::GetWorkerIndex() const {
+    return current_pool == this ? current_index : -1;
+}
+
+void TThreadPool::Submit(function<void()> task) {
+    const int own = GetWorkerIndex();
+    const int index = own >= 0 ? own : next_queue++ % queues.size();
+
+    {
+        // свои задачи поток берёт с конца, поэтому задачи извне кладутся в начало:
+        // так они выполняются в порядке постановки, и важные можно ставить первыми
+        lock_guard<mutex> guard(queues[index]->lock);
+        if (own >= 0) {
+            queues[index]->tasks.push_back(move(task));
+        } else {
+            queues[index]->tasks.push_front(move(task));
+        }
+    }
+
+    {
+        // под блокировкой, чтобы поток, проверивший счётчик перед сном, не пропустил сигнал
+        lock_guard<mutex> guard(sleep_lock);
+        pending_count++;
+    }
+    wake.notify_one();
+}
+
+bool TThreadPool::TakeTask(int index, function<void()> &task) {
+    // сначала своя очередь с конца, затем чужие с начала
+    if (pending_count.load() == 0) {
+        return false;
+    }
+
+    {
+        TQueue &queue = *queues[index];
+        lock_guard<mutex> guard(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = move(queue.tasks.back());
+            queue.tasks.pop_back();
+            pending_count--;
+            return true;
+        }
+    }
+
+    const int count = queues.size();
+    for (int i = 1; i < count; i++) {
+        TQueue &queue = *queues[(index + i) % count];
+        lock_guard<mutex> guard(queue.lock);
+        if (!queue.tasks.empty()) {
+            task = move(queue.tasks.front());
+            queue.tasks.pop_front();
+            pending_count--;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool TThreadPool::RunPendingTask() {
+    // задачи выполняются только потоками пула, поэтому GetWorkerIndex внутри задачи всегда годится как индекс
+    const int index = GetWorkerIndex();
+
+    function<void()> task;
+    if (index >= 0 && TakeTask(index, task)) {
+        task();
+        return true;
+    }
+    return false;
+}
+
+void TThreadPool::WorkerLoop(int index) {
+    current_pool = this;
+    current_index = index;
+
+    function<void()> task;
+    while (true) {
+        if (TakeTask(index, task)) {
+            task();
+            task = nullptr;
+            continue;
+        }
+
+        unique_lock<mutex> guard(sleep_lock);
+        wake.wait(guard, [this]() {
+            return stop_flag || pending_count > 0;
+        });
+        if (stop_flag && pending_count == 0) {
+            return;
+        }
+    }
+}
+
+TTaskGroup::TTaskGroup(TThreadPool &pool_arg)
+        : pool(pool_arg)
+        , remaining_count(0)
+        , error_flag(false) {
+}
+
+TTaskGroup::~TTaskGroup() {
+    // задачи ссылаются на группу, поэтому она не может исчезнуть раньше них
+    Join();
+}
+
+void TTaskGroup::Run(function<void()> task) {
+    remaining_count++;
+
+    pool.Submit([this, task = move(task)]() {
+        try {
+            task();
+        } catch (...) {
+            if (!error_flag.exchange(true)) {
+                error = current_exception();
+            }
+        }
+
+        // последняя задача будит ждущих; блокировка - чтобы сигнал не пришёл между проверкой и сном
+        lock_guard<mutex> guard(done_lock);
+        if (--remaining_count == 0) {
+            done.notify_all();
+        }
+    });
+}
+
+void TTaskGroup::Wait() {
+    Join();
+
+    if (error_flag) {
+        error_flag = false;
+        rethrow_exception(exchange(error, nullptr));
+    }
+}
+
+void TTaskGroup::Join() {
+    // поток пула помогает выполнять задачи, иначе вложенные группы заняли бы все потоки ожиданием
+    const bool worker_flag = pool.GetWorkerIndex() >= 0;
+
+    while (remaining_count > 0) {
+        if (worker_flag && pool.RunPendingTask()) {
+            continue;
+        }
+
+        unique_lock<mutex> guard(done_lock);
+        if (worker_flag) {
+            // ждём недолго: в очередях могут появиться задачи, с которыми нужно помочь
+            done.wait_for(guard, chrono::microseconds(100), [this]() {
+                return remaining_count == 0;
+            });
+        } else {
+            done.wait(guard, [this]() {
+                return remaining_count == 0;
+            });
+        }
+    }
+
+    // последняя задача отпускает блокировку уже после уменьшения счётчика, дожидаемся этого
+    lock_guard<mutex> guard(done_lock);
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// TThreadPool - пул потоков с перехватом работы: у каждого потока своя очередь,
+// свои задачи он берёт с конца, а когда их нет - забирает самые старые задачи из начала чужих очередей
+// задача, поставленная из потока пула, попадает в его собственную очередь и остаётся в его кэше;
+// задачи извне раздаются по очередям по кругу и выполняются хозяином очереди в порядке постановки
+
+class TThreadPool {
+    public:
+        explicit TThreadPool(int threads = 0); // 0 - по числу ядер
+        ~TThreadPool();
+
+        TThreadPool(const TThreadPool &) = delete;
+        TThreadPool &operator=(const TThreadPool &) = delete;
+
+        void Submit(std::function<void()> task);
+
+        int GetThreadCount() const;
+
+        // номер текущего потока в этом пуле, -1 если поток не из пула; удобен для данных на поток
+        int GetWorkerIndex() const;
+
+        // выполняет одну задачу из очередей, если она есть и вызван из потока пула;
+        // поток пула, который ждёт, тем временем помогает
+        bool RunPendingTask();
+
+    private:
+        struct TQueue {
+            std::mutex lock;
+            std::deque<std::function<void()>> tasks;
+        };
+
+        std::vector<std::unique_ptr<TQueue>> queues;
+        std::vector<std::thread> threads;
+
+        std::atomic<int> pending_count; // задачи в очередях
+        std::atomic<unsigned> next_queue; // для задач из потоков вне пула
+        std::atomic<bool> stop_flag;
+
+        std::mutex sleep_lock;
+        std::condition_variable wake;
+
+        void WorkerLoop(int index);
+        bool TakeTask(int index, std::function<void()> &task);
+};
+
+// TTaskGroup - набор задач, окончания которых можно дождаться; первое исключение из задач передаётся в Wait
+// поток пула в Wait не простаивает, а выполняет задачи из очередей, поэтому группы можно вкладывать
+
+class TTaskGroup {
+    public:
+        explicit TTaskGroup(TThreadPool &pool);
+        ~TTaskGroup();
+
+        void Run(std::function<void()> task);
+        void Wait();
+
+    private:
+        TThreadPool &pool;
+
+        std::atomic<int> remaining_count;
+        std::atomic<bool> error_flag;
+        std::exception_ptr error;
+
+        std::mutex done_lock;
+        std::condition_variable done;
+
+        void Join();
+};
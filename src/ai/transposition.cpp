@@ -0,0 +1,182 @@
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <new>
+#include <thread>
+
+#if defined(__linux__)
+#include <sys/mman.h>
+#endif
+
+#include "transposition.h"
+
+using namespace std;
+
+// data: биты 0-31 - value, 32-39 - depth, 40-41 - best_move, 42 - best_move известен, 43 - тип узла, 44 - запись занята
+enum ETranspositionBits {
+    DEPTH_SHIFT = 32,
+    MOVE_SHIFT = 40,
+    MOVE_FLAG_SHIFT = 42,
+    NODE_SHIFT = 43,
+    VALID_SHIFT = 44
+};
+
+// страницы по 2 МБ: таблица на сотни мегабайт иначе тратит промахи TLB на каждом обращении
+static const size_t HUGE_PAGE_SIZE = size_t(2) << 20;
+
+double TTranspositionStats::GetHitRate() const {
+    return probes > 0 ? double(hits) / probes : 0;
+}
+
+TTranspositionTable::TTranspositionTable(size_t size_mb)
+        : counters() {
+    // наибольшая степень двойки ячеек, которая помещается в size_mb
+    size_t count = 1;
+    while (count * 2 * sizeof(TSlot) <= max<size_t>(size_mb, 1) << 20) {
+        count *= 2;
+    }
+
+    mask = count - 1;
+    allocated_bytes = (count * sizeof(TSlot) + HUGE_PAGE_SIZE - 1) / HUGE_PAGE_SIZE * HUGE_PAGE_SIZE;
+
+    void *memory = aligned_alloc(HUGE_PAGE_SIZE, allocated_bytes);
+    if (!memory) {
+        throw bad_alloc();
+    }
+#if defined(__linux__) && defined(MADV_HUGEPAGE)
+    madvise(memory, allocated_bytes, MADV_HUGEPAGE);
+#endif
+
+    slots = static_cast<TSlot *>(memory);
+    for (size_t i = 0; i < count; i++) {
+        new (&slots[i]) TSlot();
+    }
+    clear();
+}
+
+TTranspositionTable::~TTranspositionTable() {
+    free(slots);
+}
+
+void TTranspositionTable::clear() {
+    for (size_t i = 0; i <= mask; i++) {
+        slots[i].check.store(0, memory_order_relaxed);
+        slots[i].data.store(0, memory_order_relaxed);
+    }
+    ResetStats();
+}
+
+size_t TTranspositionTable::size() const {
+    return mask + 1;
+}
+
+size_t TTranspositionTable::GetSizeBytes() const {
+    return allocated_bytes;
+}
+
+TTranspositionTable::TSlot &TTranspositionTable::GetSlot(uint64_t key, ETranspositionNode node) {
+    // поля отличаются в основном младшими тетрадами, поэтому ключ перемешивается (финализатор splitmix64)
+    uint64_t x = key ^ (static_cast<uint64_t>(node) << 63);
+    x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+    x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+    x ^= x >> 31;
+    return slots[x & mask];
+}
+
+TTranspositionTable::TCounters &TTranspositionTable::GetCounters() {
+    static thread_local const size_t shard = hash<thread::id>()(this_thread::get_id()) % COUNTER_SHARDS;
+    return counters[shard];
+}
+
+uint64_t TTranspositionTable::Pack(ETranspositionNode node, const TTranspositionEntry &entry) {
+    uint32_t value_bits;
+    memcpy(&value_bits, &entry.value, sizeof(value_bits));
+
+    return uint64_t(value_bits)
+         | uint64_t(min(max(entry.depth, 0), 0xFF)) << DEPTH_SHIFT
+         | uint64_t(static_cast<int>(entry.best_move)) << MOVE_SHIFT
+         | uint64_t(entry.move_flag) << MOVE_FLAG_SHIFT
+         | uint64_t(static_cast<int>(node)) << NODE_SHIFT
+         | uint64_t(1) << VALID_SHIFT;
+}
+
+bool TTranspositionTable::Unpack(uint64_t data, ETranspositionNode node, TTranspositionEntry &entry) {
+    if (!((data >> VALID_SHIFT) & 1) || ((data >> NODE_SHIFT) & 1) != static_cast<uint64_t>(node)) {
+        return false;
+    }
+
+    const uint32_t value_bits = static_cast<uint32_t>(data);
+    memcpy(&entry.value, &value_bits, sizeof(value_bits));
+    entry.depth = (data >> DEPTH_SHIFT) & 0xFF;
+    entry.best_move = static_cast<ETurnDirection>((data >> MOVE_SHIFT) & 0x3);
+    entry.move_flag = (data >> MOVE_FLAG_SHIFT) & 1;
+    return true;
+}
+
+bool TTranspositionTable::Probe(const TBoard &board, ETranspositionNode node, TTranspositionEntry &entry) {
+    const uint64_t key = board.GetRaw();
+    TSlot &slot = GetSlot(key, node);
+    TCounters &stats = GetCounters();
+
+    // порядок чтения не важен: несогласованная пара не пройдёт проверку ключа
+    const uint64_t data = slot.data.load(memory_order_relaxed);
+    const uint64_t check = slot.check.load(memory_order_relaxed);
+
+    stats.probes.fetch_add(1, memory_order_relaxed);
+    if (!((data >> VALID_SHIFT) & 1)) {
+        return false;
+    }
+    if ((check ^ data) != key || !Unpack(data, node, entry)) {
+        stats.collisions.fetch_add(1, memory_order_relaxed);
+        return false;
+    }
+
+    stats.hits.fetch_add(1, memory_order_relaxed);
+    return true;
+}
+
+void TTranspositionTable::Store(const TBoard &board, ETranspositionNode node, const TTranspositionEntry &entry) {
+    const uint64_t key = board.GetRaw();
+    TSlot &slot = GetSlot(key, node);
+    TCounters &stats = GetCounters();
+
+    const uint64_t old_data = slot.data.load(memory_order_relaxed);
+    const uint64_t old_check = slot.check.load(memory_order_relaxed);
+    const bool valid_flag = (old_data >> VALID_SHIFT) & 1;
+
+    TTranspositionEntry old_entry;
+    if (valid_flag && (old_check ^ old_data) == key && Unpack(old_data, node, old_entry)) {
+        if (old_entry.depth > entry.depth) {
+            return; // та же позиция уже посчитана глубже
+        }
+    } else if (valid_flag) {
+        stats.replacements.fetch_add(1, memory_order_relaxed);
+    }
+
+    const uint64_t data = Pack(node, entry);
+    slot.check.store(key ^ data, memory_order_relaxed);
+    slot.data.store(data, memory_order_relaxed);
+    stats.stores.fetch_add(1, memory_order_relaxed);
+}
+
+TTranspositionStats TTranspositionTable::GetStats() const {
+    TTranspositionStats result;
+    for (const TCounters &shard : counters) {
+        result.probes += shard.probes.load(memory_order_relaxed);
+        result.hits += shard.hits.load(memory_order_relaxed);
+        result.collisions += shard.collisions.load(memory_order_relaxed);
+        result.stores += shard.stores.load(memory_order_relaxed);
+        result.replacements += shard.replacements.load(memory_order_relaxed);
+    }
+    return result;
+}
+
+void TTranspositionTable::ResetStats() {
+    for (TCounters &shard : counters) {
+        shard.probes = 0;
+        shard.hits = 0;
+        shard.collisions = 0;
+        shard.stores = 0;
+        shard.replacements = 0;
+    }
+}
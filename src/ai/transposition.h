@@ -0,0 +1,86 @@
+#pragma once
+
+#include <array>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+
+#include <engine/engine.h>
+
+// TTranspositionTable - таблица позиций фиксированного размера (степень двойки), общая для потоков перебора
+// ключ - упакованное поле 4x4; запись - два 64-битных слова: ключ xor данные и сами данные
+// запись и чтение без блокировок: если два потока пишут одну ячейку одновременно, у прочитанной
+// пары не сойдётся ключ, и она считается промахом (метод Хайата)
+
+enum ETranspositionSettings {
+    TRANSPOSITION_DEFAULT_MB = 16
+};
+
+enum class ETranspositionNode : uint8_t {
+    MOVE, // ход игрока: поле после появления тайла
+    CHANCE // появление тайла: поле после хода
+};
+
+struct TTranspositionEntry {
+    float value = 0;
+    int depth = 0; // на сколько ходов вперёд посчитано value
+    bool move_flag = false; // best_move известен
+    ETurnDirection best_move = ETurnDirection::UP;
+};
+
+struct TTranspositionStats {
+    uint64_t probes = 0;
+    uint64_t hits = 0; // ключ совпал
+    uint64_t collisions = 0; // в ячейке другая позиция или запись, которую пишут в этот момент
+    uint64_t stores = 0;
+    uint64_t replacements = 0; // запись вытеснила другую позицию
+
+    double GetHitRate() const;
+};
+
+class TTranspositionTable {
+    public:
+        explicit TTranspositionTable(size_t size_mb = TRANSPOSITION_DEFAULT_MB);
+        ~TTranspositionTable();
+
+        TTranspositionTable(const TTranspositionTable &) = delete;
+        TTranspositionTable &operator=(const TTranspositionTable &) = delete;
+
+        // одна ячейка на позицию; при совпадении ключа запись с меньшей глубиной не заменяет большую
+        bool Probe(const TBoard &board, ETranspositionNode node, TTranspositionEntry &entry);
+        void Store(const TBoard &board, ETranspositionNode node, const TTranspositionEntry &entry);
+
+        void clear(); // не потокобезопасно
+        size_t size() const; // число ячеек
+        size_t GetSizeBytes() const;
+
+        TTranspositionStats GetStats() const;
+        void ResetStats();
+
+    private:
+        struct TSlot {
+            std::atomic<uint64_t> check; // ключ xor data
+            std::atomic<uint64_t> data;
+        };
+
+        // счётчики разнесены по строкам кэша, иначе потоки мешали бы друг другу на каждом обращении
+        struct alignas(64) TCounters {
+            std::atomic<uint64_t> probes, hits, collisions, stores, replacements;
+        };
+
+        enum {
+            COUNTER_SHARDS = 16
+        };
+
+        TSlot *slots;
+        size_t mask;
+        size_t allocated_bytes;
+
+        std::array<TCounters, COUNTER_SHARDS> counters;
+
+        TSlot &GetSlot(uint64_t key, ETranspositionNode node);
+        TCounters &GetCounters();
+
+        static uint64_t Pack(ETranspositionNode node, const TTranspositionEntry &entry);
+        static bool Unpack(uint64_t data, ETranspositionNode node, TTranspositionEntry &entry);
+};
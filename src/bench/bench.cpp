@@ -0,0 +1,324 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include <engine/engine.h>
+#include <engine/batch.h>
+#include <engine/simd.h>
+
+// 2048_bench - микробенчмарки горячих путей движка на фиксированных наборах полей
+// каждый замер: прогрев, затем несколько повторений; в JSON - нс на операцию и выделений памяти на операцию,
+// поэтому вывод двух сборок можно сравнить построчно
+// 2048_bench [--repetitions N] [--filter SUBSTRING] [--output FILE]
+// запускать из сборки с оптимизацией: cmake -DCMAKE_BUILD_TYPE=Release
+
+using namespace std;
+
+static atomic<size_t> allocations_count(0); // сколько раз вызывался глобальный operator new
+
+void *operator new(size_t size) {
+    allocations_count.fetch_add(1, memory_order_relaxed);
+    if (void *result = malloc(size ? size : 1)) {
+        return result;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
+enum EBenchSettings {
+    CORPUS_SIZE = 1 << 16, // полей в наборе, проход по набору - CORPUS_SIZE операций
+    CORPUS_SEED = 2048,
+    DEFAULT_REPETITIONS = 10,
+    MIN_REPETITION_MS = 20 // проходов в повторении столько, чтобы оно шло не меньше этого
+};
+
+struct TBenchCase {
+    string name;
+    function<void()> body; // один проход по набору
+    size_t ops_per_pass;
+};
+
+struct TBenchResult {
+    string name;
+    size_t ops = 0; // операций в одном повторении
+    vector<double> ns_per_op; // по повторениям
+    double allocations_per_op = 0;
+};
+
+struct TCorpus {
+    // позиции из случайных партий; after_move - те же партии сразу после хода, до появления тайла
+    vector<TEngineState> states;
+    vector<TEngineState> after_move;
+    vector<ETurnDirection> turns; // случайные ходы, в том числе не меняющие поле
+    vector<ETurnDirection> legal_turns; // ход, которым получен after_move
+    vector<vector<vector<EEngineTileType>>> fields;
+};
+
+static volatile uint64_t sink; // чтобы компилятор не выбросил результат
+
+static TCorpus MakeCorpus() {
+    TCorpus corpus;
+    mt19937 generator(CORPUS_SEED);
+
+    while (corpus.states.size() < CORPUS_SIZE) {
+        TEngine engine(generator());
+        engine.SetKeepPlaying(true);
+
+        while (!engine.IsEnd() && corpus.states.size() < CORPUS_SIZE) {
+            const TEngineState before = engine.Snapshot();
+
+            ETurnDirection turn = static_cast<ETurnDirection>(generator() % 4);
+            corpus.turns.push_back(turn);
+            while (!(engine.LegalMoves() & (1 << static_cast<int>(turn)))) {
+                turn = static_cast<ETurnDirection>((static_cast<int>(turn) + 1) % 4);
+            }
+
+            engine.ApplyMove(turn);
+            corpus.states.push_back(before);
+            corpus.after_move.push_back(engine.Snapshot());
+            corpus.legal_turns.push_back(turn);
+            engine.AfterTurn();
+        }
+    }
+
+    // конструктор из поля медленнее, ему хватит части набора
+    for (size_t i = 0; i < CORPUS_SIZE / 16; i++) {
+        const TBoard &board = corpus.states[i].board;
+        vector<vector<EEngineTileType>> field(TEngine::SIZE_X, vector<EEngineTileType>(TEngine::SIZE_Y));
+        for (int x = 0; x < TEngine::SIZE_X; x++) {
+            for (int y = 0; y < TEngine::SIZE_Y; y++) {
+                field[x][y] = board(x, y);
+            }
+        }
+        corpus.fields.push_back(field);
+    }
+
+    return corpus;
+}
+
+static double RunPasses(const TBenchCase &c, int passes) {
+    const auto start = chrono::steady_clock::now();
+    for (int i = 0; i < passes; i++) {
+        c.body();
+    }
+    const chrono::duration<double, nano> elapsed = chrono::steady_clock::now() - start;
+    return elapsed.count();
+}
+
+static TBenchResult Measure(const TBenchCase &c, int repetitions) {
+    TBenchResult result;
+    result.name = c.name;
+
+    // прогрев: таблицы и набор попадают в кэш, заодно подбирается число проходов
+    // разовые выделения прогрева (буферы, которые потом переиспользуются) в allocations_per_op не входят
+    const double warm_ns = RunPasses(c, 1);
+
+    const int passes = max(1, int(MIN_REPETITION_MS * 1e6 / max(warm_ns, 1.0)));
+    result.ops = passes * c.ops_per_pass;
+
+    const size_t allocations_before = allocations_count;
+    for (int i = 0; i < repetitions; i++) {
+        result.ns_per_op.push_back(RunPasses(c, passes) / result.ops);
+    }
+    result.allocations_per_op = double(allocations_count - allocations_before) / (double(repetitions) * result.ops);
+    return result;
+}
+
+static vector<TBenchCase> MakeCases(const TCorpus &corpus) {
+    // состояние для замеров, изменяемое проходами; поля хранятся отдельно, чтобы проходы не зависели друг от друга
+    static vector<TBoard> boards, moved;
+    static vector<TMoveSummary> summaries;
+    static TEngine engine(1);
+
+    for (const TEngineState &state : corpus.states) {
+        boards.push_back(state.board);
+    }
+    moved.resize(boards.size());
+    summaries.resize(boards.size());
+
+    const size_t n = corpus.states.size();
+
+    vector<TBenchCase> cases = {
+        {"engine/construct_seed", []() {
+            for (size_t i = 0; i < CORPUS_SIZE; i++) {
+                TEngine e(i);
+                sink = sink + e.GetBoard().GetRaw();
+            }
+        }, CORPUS_SIZE},
+        {"engine/construct_field", [&corpus]() {
+            for (size_t i = 0; i < corpus.fields.size(); i++) {
+                TEngine e(corpus.fields[i], i);
+                sink = sink + e.IsEnd();
+            }
+        }, corpus.fields.size()},
+        {"engine/make_turn", [&corpus, n]() {
+            for (size_t i = 0; i < n; i++) {
+                engine.Restore(corpus.states[i]);
+                sink = sink + bool(engine.MakeTurn(corpus.turns[i]));
+            }
+        }, n},
+        {"engine/apply_move", [&corpus, n]() {
+            for (size_t i = 0; i < n; i++) {
+                engine.Restore(corpus.states[i]);
+                sink = sink + engine.ApplyMove(corpus.turns[i]);
+            }
+        }, n},
+        {"engine/after_turn", [&corpus, n]() {
+            // AddRandomTile и RefreshWinLoseState после хода, изменившего поле
+            for (size_t i = 0; i < n; i++) {
+                engine.Restore(corpus.after_move[i]);
+                sink = sink + engine.AfterTurn().first;
+            }
+        }, n},
+        {"engine/refresh_win_lose", [&corpus, n]() {
+            // RefreshWinLoseState закрыт, SetKeepPlaying - только он и одно присваивание
+            for (size_t i = 0; i < n; i++) {
+                engine.Restore(corpus.states[i]);
+                engine.SetKeepPlaying(i & 1);
+                sink = sink + engine.IsLose();
+            }
+        }, n},
+        {"engine/legal_moves", [n]() {
+            for (size_t i = 0; i < n; i++) {
+                sink = sink + TEngine::LegalMoves(boards[i]);
+            }
+        }, n},
+        {"engine/move_board", [&corpus, n]() {
+            for (size_t i = 0; i < n; i++) {
+                moved[i] = TEngine::MoveBoard(boards[i], corpus.turns[i], summaries[i]);
+            }
+        }, n},
+        {"engine/describe_turn", [&corpus, n]() {
+            for (size_t i = 0; i < n; i++) {
+                sink = sink + TEngine::DescribeTurn(boards[i], corpus.legal_turns[i]).shifts.size();
+            }
+        }, n},
+        {"moves/scalar", [&corpus, n]() {
+            MoveBoardsScalar(boards.data(), corpus.turns.data(), moved.data(), summaries.data(), n);
+        }, n},
+        {"moves/dispatch", [&corpus, n]() {
+            MoveBoards(boards.data(), corpus.turns.data(), moved.data(), summaries.data(), n);
+        }, n},
+    };
+
+    if (HasAvx2Moves()) {
+        cases.push_back({"moves/avx2", [&corpus, n]() {
+            MoveBoardsAvx2(boards.data(), corpus.turns.data(), moved.data(), summaries.data(), n);
+        }, n});
+    }
+
+    // партии пакета ходят случайно, набор ходов - тот же
+    static TEngineBatch batch(1024, CORPUS_SEED);
+    static vector<ETurnDirection> actions(batch.size());
+    static vector<uint32_t> rewards;
+    static vector<uint8_t> dones;
+    cases.push_back({"batch/step_1024", [&corpus, n]() {
+        for (size_t i = 0; i + actions.size() <= n; i += actions.size()) {
+            copy(corpus.turns.begin() + i, corpus.turns.begin() + i + actions.size(), actions.begin());
+            batch.Step(actions, rewards, dones);
+        }
+    }, n / batch.size() * batch.size()});
+
+    return cases;
+}
+
+static double Median(vector<double> values) {
+    sort(values.begin(), values.end());
+    const size_t middle = values.size() / 2;
+    return values.size() % 2 ? values[middle] : (values[middle - 1] + values[middle]) / 2;
+}
+
+static string ToJson(const vector<TBenchResult> &results, int repetitions) {
+    ostringstream out;
+    out.precision(4);
+    out << fixed;
+
+    out << "{\n";
+    out << "  \"context\": {\n";
+#if defined(NDEBUG)
+    out << "    \"assertions\": false,\n";
+#else
+    out << "    \"assertions\": true,\n";
+#endif
+    out << "    \"avx2\": " << (HasAvx2Moves() ? "true" : "false") << ",\n";
+    out << "    \"corpus_size\": " << CORPUS_SIZE << ",\n";
+    out << "    \"corpus_seed\": " << CORPUS_SEED << ",\n";
+    out << "    \"repetitions\": " << repetitions << "\n";
+    out << "  },\n";
+    out << "  \"benchmarks\": [\n";
+    for (size_t i = 0; i < results.size(); i++) {
+        const TBenchResult &r = results[i];
+        out << "    {\"name\": \"" << r.name << "\", \"ops\": " << r.ops
+            << ", \"ns_per_op\": " << Median(r.ns_per_op)
+            << ", \"ns_per_op_min\": " << *min_element(r.ns_per_op.begin(), r.ns_per_op.end())
+            << ", \"ns_per_op_max\": " << *max_element(r.ns_per_op.begin(), r.ns_per_op.end())
+            << ", \"allocations_per_op\": " << r.allocations_per_op << "}"
+            << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+    return out.str();
+}
+
+static const char USAGE[] = "usage: 2048_bench [--repetitions N] [--filter SUBSTRING] [--output FILE]";
+
+int main(int argc, char **argv) {
+    int repetitions = DEFAULT_REPETITIONS;
+    string filter, output;
+
+    for (int i = 1; i < argc; i += 2) {
+        const string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            cerr << USAGE << endl;
+            return 1;
+        }
+
+        if (arg == "--repetitions") {
+            repetitions = max(1, atoi(argv[i + 1]));
+        } else if (arg == "--filter") {
+            filter = argv[i + 1];
+        } else if (arg == "--output") {
+            output = argv[i + 1];
+        } else {
+            cerr << "Unknown argument " << arg << endl;
+            cerr << USAGE << endl;
+            return 1;
+        }
+    }
+
+    const TCorpus corpus = MakeCorpus();
+
+    vector<TBenchResult> results;
+    for (const TBenchCase &c : MakeCases(corpus)) {
+        if (c.name.find(filter) != string::npos) {
+            results.push_back(Measure(c, repetitions));
+            cerr << c.name << " " << Median(results.back().ns_per_op) << " ns/op" << endl;
+        }
+    }
+
+    const string json = ToJson(results, repetitions);
+    if (output.empty()) {
+        cout << json;
+    } else {
+        ofstream(output) << json;
+    }
+    return 0;
+}
@@ -0,0 +1,148 @@
+#include <algorithm>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <ai/parallel_solver.h>
+
+// 2048_solver_bench - ускорение параллельного expectimax относительно одного потока
+// на фиксированном наборе позиций из партии с постоянным seed; для каждого числа потоков - свежая таблица позиций
+// 2048_solver_bench [--depth D] [--threads-max K] [--positions N] [--output FILE]
+// запускать из сборки с оптимизацией: cmake -DCMAKE_BUILD_TYPE=Release
+
+using namespace std;
+
+enum ESolverBenchSettings {
+    CORPUS_SEED = 2048,
+    CORPUS_STRIDE = 8, // берётся каждая восьмая позиция партии
+    TABLE_MB = 64
+};
+
+struct TSolverRun {
+    int threads = 0;
+    double seconds = 0;
+    double max_move_seconds = 0;
+    uint64_t nodes = 0;
+    double hit_rate = 0;
+};
+
+static vector<TBoard> MakeCorpus(int positions) {
+    // партия решателем глубины 2: позиции похожи на настоящие, а набор строится быстро
+    vector<TBoard> corpus;
+    TSolver solver;
+    TSolverBudget budget;
+    budget.depth = 2;
+
+    for (uint64_t seed = CORPUS_SEED; int(corpus.size()) < positions; seed++) {
+        TEngine engine(seed);
+        engine.SetKeepPlaying(true);
+
+        for (int move = 0; !engine.IsEnd() && int(corpus.size()) < positions; move++) {
+            if (move % CORPUS_STRIDE == 0) {
+                corpus.push_back(engine.GetBoard());
+            }
+            engine.ApplyMove(solver.BestMove(engine, budget).best_move);
+            engine.AfterTurn();
+        }
+    }
+    return corpus;
+}
+
+static TSolverRun Run(const vector<TBoard> &corpus, int threads, int depth) {
+    TThreadPool pool(threads);
+    TTranspositionTable table(TABLE_MB);
+    TParallelSolver solver(pool, table);
+
+    TSolverBudget budget;
+    budget.depth = depth;
+
+    TSolverRun run;
+    run.threads = threads;
+    for (const TBoard &board : corpus) {
+        const TSolverResult result = solver.BestMove(board, budget);
+        run.seconds += result.seconds;
+        run.max_move_seconds = max(run.max_move_seconds, result.seconds);
+        run.nodes += result.nodes;
+    }
+    run.hit_rate = table.GetStats().GetHitRate();
+    return run;
+}
+
+static const char USAGE[] = "usage: 2048_solver_bench [--depth D] [--threads-max K] [--positions N] [--output FILE]";
+
+int main(int argc, char **argv) {
+    int depth = 4;
+    int threads_max = max(1u, thread::hardware_concurrency());
+    int positions = 64;
+    string output;
+
+    for (int i = 1; i < argc; i += 2) {
+        const string arg = argv[i];
+        if (i + 1 >= argc) {
+            cerr << "Missing value for " << arg << endl;
+            cerr << USAGE << endl;
+            return 1;
+        }
+
+        if (arg == "--depth") {
+            depth = max(1, atoi(argv[i + 1]));
+        } else if (arg == "--threads-max") {
+            threads_max = max(1, atoi(argv[i + 1]));
+        } else if (arg == "--positions") {
+            positions = max(1, atoi(argv[i + 1]));
+        } else if (arg == "--output") {
+            output = argv[i + 1];
+        } else {
+            cerr << "Unknown argument " << arg << endl;
+            cerr << USAGE << endl;
+            return 1;
+        }
+    }
+
+    const vector<TBoard> corpus = MakeCorpus(positions);
+
+    // 1, 2, 4, ... и само threads_max
+    vector<int> thread_counts;
+    for (int threads = 1; threads < threads_max; threads *= 2) {
+        thread_counts.push_back(threads);
+    }
+    thread_counts.push_back(threads_max);
+
+    vector<TSolverRun> runs;
+    for (int threads : thread_counts) {
+        runs.push_back(Run(corpus, threads, depth));
+        cerr << threads << " threads: " << runs.back().seconds / corpus.size() * 1e3 << " ms/move, speedup "
+             << runs.front().seconds / runs.back().seconds << endl;
+    }
+
+    ostringstream out;
+    out.precision(4);
+    out << fixed;
+    out << "{\n";
+    out << "  \"context\": {\"depth\": " << depth << ", \"positions\": " << corpus.size()
+        << ", \"hardware_threads\": " << thread::hardware_concurrency() << ", \"table_mb\": " << TABLE_MB << "},\n";
+    out << "  \"runs\": [\n";
+    for (size_t i = 0; i < runs.size(); i++) {
+        const TSolverRun &run = runs[i];
+        out << "    {\"threads\": " << run.threads
+            << ", \"ms_per_move\": " << run.seconds / corpus.size() * 1e3
+            << ", \"ms_per_move_max\": " << run.max_move_seconds * 1e3
+            << ", \"nodes_per_second\": " << run.nodes / run.seconds
+            << ", \"hit_rate\": " << run.hit_rate
+            << ", \"speedup\": " << runs.front().seconds / run.seconds << "}"
+            << (i + 1 < runs.size() ? "," : "") << "\n";
+    }
+    out << "  ]\n";
+    out << "}\n";
+
+    if (output.empty()) {
+        cout << out.str();
+    } else {
+        ofstream(output) << out.str();
+    }
+    return 0;
+}
@@ -113,6 +113,10 @@ void TDisplay::TImpl::InitTextures() {
     TileTextures[ETileType::TILE_512] = LoadTexture("data/512.png");
     TileTextures[ETileType::TILE_1024] = LoadTexture("data/1024.png");
     TileTextures[ETileType::TILE_2048] = LoadTexture("data/2048.png");
+    // своих картинок у тайлов больше 2048 пока нет
+    TileTextures[ETileType::TILE_4096] = TileTextures[ETileType::TILE_2048];
+    TileTextures[ETileType::TILE_8192] = TileTextures[ETileType::TILE_2048];
+    TileTextures[ETileType::TILE_16384] = TileTextures[ETileType::TILE_2048];
 
     WinTexture = LoadTexture("data/win.png");
     LoseTexture = LoadTexture("data/lose.png");
@@ -160,6 +164,13 @@ bool TDisplay::TImpl::IsKeyPressed(EKey key) const {
         case EKey::KEY_RIGHT:
             return glfwGetKey(Window, GLFW_KEY_D) == GLFW_PRESS ||
                    glfwGetKey(Window, GLFW_KEY_RIGHT) == GLFW_PRESS;
+        case EKey::KEY_UNDO:
+            return glfwGetKey(Window, GLFW_KEY_Z) == GLFW_PRESS ||
+                   glfwGetKey(Window, GLFW_KEY_BACKSPACE) == GLFW_PRESS;
+        case EKey::KEY_REDO:
+            return glfwGetKey(Window, GLFW_KEY_Y) == GLFW_PRESS;
+        case EKey::KEY_HINT:
+            return glfwGetKey(Window, GLFW_KEY_H) == GLFW_PRESS;
         default:
             return false;
     }
@@ -15,6 +15,9 @@ enum class ETileType {
     TILE_512,
     TILE_1024,
     TILE_2048,
+    TILE_4096,
+    TILE_8192,
+    TILE_16384,
 };
 
 enum class EKey {
@@ -22,6 +25,9 @@ enum class EKey {
     KEY_DOWN,
     KEY_LEFT,
     KEY_RIGHT,
+    KEY_UNDO,
+    KEY_REDO,
+    KEY_HINT,
 };
 
 namespace std {
@@ -34,6 +34,9 @@ pair<optional<EKey>, bool> TView::GetKeyPressed() {
     keys[EKey::KEY_RIGHT]   = display->IsKeyPressed(EKey::KEY_RIGHT);
     keys[EKey::KEY_DOWN]    = display->IsKeyPressed(EKey::KEY_DOWN);
     keys[EKey::KEY_UP]      = display->IsKeyPressed(EKey::KEY_UP);
+    keys[EKey::KEY_UNDO]    = display->IsKeyPressed(EKey::KEY_UNDO);
+    keys[EKey::KEY_REDO]    = display->IsKeyPressed(EKey::KEY_REDO);
+    keys[EKey::KEY_HINT]    = display->IsKeyPressed(EKey::KEY_HINT);
     
     bool one = false; 
     bool more_than_one = false;
@@ -56,6 +59,10 @@ pair<optional<EKey>, bool> TView::GetKeyPressed() {
     return make_pair(result, one);
 }
 
+bool TView::IsDirection(EKey key) {
+    return key == EKey::KEY_LEFT || key == EKey::KEY_RIGHT || key == EKey::KEY_UP || key == EKey::KEY_DOWN;
+}
+
 ETurnDirection TView::KeyToDirection(EKey key) {
     switch(key) {
         case EKey::KEY_LEFT:
@@ -80,8 +87,8 @@ ETurnDirection TView::KeyToDirection(EKey key) {
     }
 }
 
-optional<ETurnDirection> TView::GetTurn() {
-    // возвращает ход, если он есть
+optional<EKey> TView::GetKey() {
+    // возвращает кнопку, если она нажата и ещё не была обработана
     
     auto key = GetKeyPressed();
     
@@ -90,10 +97,8 @@ optional<ETurnDirection> TView::GetTurn() {
         return nullopt;
     } else { // если есть хотя бы одна нажатая кнопка 
         if (key.first and !turn_flag) { // и она одна, и ход может произойти
-            auto current_key = *(key.first);
-            ETurnDirection result = KeyToDirection(current_key);
             turn_flag = true;
-            return make_optional(result);
+            return key.first;
             
         } else { // если кнопка не одна, или ход уже был
             return nullopt;
@@ -101,6 +106,17 @@ optional<ETurnDirection> TView::GetTurn() {
     }
 }
 
+optional<ETurnDirection> TView::GetTurn() {
+    // возвращает ход, если он есть; остальные кнопки пропускаются
+    auto key = GetKey();
+    
+    if (key && IsDirection(*key)) {
+        return make_optional(KeyToDirection(*key));
+    } else {
+        return nullopt;
+    }
+}
+
 void TView::DrawField(const TEngine &engine) {
     // отрисовывает поле
     for (int i = 0; i < engine.GetXSize(); i++) {
@@ -119,10 +135,10 @@ void TView::Render(const TEngine &engine) {
     display->Render();
 }
 
-int TView::GetLengthOfMotion(const vector<TShiftOfTile> shifts) {
+int TView::GetLengthOfMotion(const TEngineTurnResult &turn_result) {
     // возвращает максимальное число тайлов, на которое происходит перемещение (при стандартном поле это целое число от 1 до 3)
     int result = 0;
-    for (auto val : shifts) {
+    for (auto const &val : turn_result.shifts) {
         result = max(result, max(abs(val.x_old - val.x_new),
                                  abs(val.y_old - val.y_new)));
     }
@@ -180,10 +196,10 @@ pair<double, double> TView::GetCoordinates(double elapsed_time, double full_move
 }
 
 
-void TView::Animate(const vector<TShiftOfTile> shifts, const vector<SNewTile> new_tiles, const TEngine &engine) {
+void TView::Animate(const TEngineTurnResult &turn_result, const TEngine &engine) {
     // Анимирует переданные сдвиги 
     
-    const int length_of_motion = GetLengthOfMotion(shifts);
+    const int length_of_motion = GetLengthOfMotion(turn_result);
     const double current_move_time = MOVE_TIME * length_of_motion / MAX_MOTION_LENGTH; // время всего движения
     
     
@@ -195,7 +211,7 @@ void TView::Animate(const vector<TShiftOfTile> shifts, const vector<SNewTile> ne
     
     int i = 0;
     while ((elapsed_time = (display->GetTime() - old_time)) < current_move_time) {
-        for (auto const &shift : shifts) {
+        for (auto const &shift : turn_result.shifts) {
             pair<double, double> coordinates;
             coordinates = GetCoordinates(elapsed_time, current_move_time, length_of_motion, shift);
             
@@ -216,7 +232,7 @@ void TView::Animate(const vector<TShiftOfTile> shifts, const vector<SNewTile> ne
         double cells_moved = elapsed_time * length_of_motion / current_move_time;
         
         // прорисовка появляющихся клеток
-        for (auto const &new_tile : new_tiles) {
+        for (auto const &new_tile : turn_result.new_tiles) {
             if (cells_moved + 1.5 > new_tile.cells_to_appear) {
                 display->DrawTile(new_tile.y, new_tile.x, *TileToTile(new_tile.type), min(1.0f, static_cast<float>(cells_moved - new_tile.cells_to_appear + 1)));
             }
@@ -10,7 +10,7 @@
 
 const double MOVE_TIME = 0.7; // максимальное время перемещения
 const double RANDOM_TILE_TIME = 0.15;
-const int MAX_MOTION_LENGTH = std::max(SIZE_OF_FIELD_X, SIZE_OF_FIELD_Y) - 1;
+const int MAX_MOTION_LENGTH = std::max(TEngine::SIZE_X, TEngine::SIZE_Y) - 1;
 
 
 class TView {
@@ -18,11 +18,15 @@ class TView {
         TView(TDisplay *display_arg);
         ~TView();
         
+        std::optional<EKey> GetKey(); // нажатая кнопка, один раз за нажатие
         std::optional<ETurnDirection> GetTurn();
         
+        static bool IsDirection(EKey key);
+        static ETurnDirection KeyToDirection(EKey key);
+        
         virtual void Render(const TEngine &engine);
 
-        virtual void Animate(const std::vector<TShiftOfTile> shifts, const std::vector<SNewTile> new_tiles, const TEngine &engine);
+        virtual void Animate(const TEngineTurnResult &turn_result, const TEngine &engine);
         void AnimateRandomTile(int x, int y, const TEngine &engine);
 
         virtual void WinScreen(const TEngine &engine);
@@ -35,7 +39,6 @@ class TView {
         
         bool turn_flag; // true если ход сделан, а кнопки ещё не отжаты
         
-        static ETurnDirection KeyToDirection(EKey key);
         static std::optional<ETileType> TileToTile(EEngineTileType tile);
         
         
@@ -44,7 +47,7 @@ class TView {
         std::pair<std::optional<EKey>, bool> GetKeyPressed();
         
         //АНИМАЦИЯ
-        static int GetLengthOfMotion(const std::vector<TShiftOfTile> shifts);
+        static int GetLengthOfMotion(const TEngineTurnResult &turn_result);
         std::pair<double, double> GetCoordinates(double elapsed_time, double full_move_time, int length_of_motion, const TShiftOfTile &shift);
         float GetTransparency(double elapsed_time, double current_move_time, const TShiftOfTile &shift, const std::pair<double, double> &coordinates);
 };
\ No newline at end of file
@@ -0,0 +1,134 @@
+#include <algorithm>
+#include <stdexcept>
+#include <assert.h>
+
+#include "batch.h"
+
+using namespace std;
+
+
+template <int X, int Y>
+TBasicEngineBatch<X, Y>::TBasicEngineBatch(size_t count, uint64_t seed)
+        : boards(count)
+        , random_s0(count)
+        , random_s1(count)
+        , random_s2(count)
+        , random_s3(count)
+        , random_words(count)
+        , scores(count)
+        , move_counts(count)
+        , empty_counts(count)
+        , max_tiles(count)
+        , win_tile(EEngineTileType::TILE_2048)
+        , keep_playing_flag(false) {
+    for (size_t i = 0; i < count; i++) {
+        TRandom(seed + i).GetState(random_s0[i], random_s1[i], random_s2[i], random_s3[i]);
+        Reset(i);
+    }
+}
+
+template <int X, int Y>
+uint64_t TBasicEngineBatch<X, Y>::NextRandom(size_t i) {
+    return TRandom::Step(random_s0[i], random_s1[i], random_s2[i], random_s3[i]);
+}
+
+template <int X, int Y>
+void TBasicEngineBatch<X, Y>::Reset(size_t i) {
+    // новая партия продолжает последовательность генератора старой
+    boards[i] = TBoardType();
+    for (int k = 0; k < TILES_AT_START; k++) {
+        TEngineType::SpawnTile(boards[i], NextRandom(i), true);
+    }
+
+    scores[i] = 0;
+    move_counts[i] = 0;
+    empty_counts[i] = X * Y - TILES_AT_START;
+    max_tiles[i] = EEngineTileType::TILE_2;
+}
+
+template <int X, int Y>
+void TBasicEngineBatch<X, Y>::Step(const vector<ETurnDirection> &actions, vector<uint32_t> &rewards, vector<uint8_t> &dones) {
+    const size_t count = boards.size();
+
+    if (actions.size() != count) {
+        throw runtime_error("Wrong number of actions");
+    }
+
+    rewards.resize(count);
+    dones.resize(count);
+
+    // случайные числа на ход вперёд: простая арифметика над массивами, без ветвлений
+    for (size_t i = 0; i < count; i++) {
+        random_words[i] = NextRandom(i);
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        TMoveSummary summary;
+        const TBoardType moved = TEngineType::MoveBoard(boards[i], actions[i], summary);
+        const bool changed = moved != boards[i];
+
+        boards[i] = moved;
+        rewards[i] = summary.score;
+        scores[i] += summary.score;
+        move_counts[i] += changed;
+        empty_counts[i] += summary.merges;
+        max_tiles[i] = max(max_tiles[i], summary.max_tile);
+
+        if (changed) {
+            const int cell = TEngineType::SpawnTile(boards[i], random_words[i], false);
+            assert(cell >= 0); // после хода, меняющего поле, пустая клетка есть всегда
+            empty_counts[i]--;
+            max_tiles[i] = max(max_tiles[i], boards[i](cell / Y, cell % Y));
+        }
+
+        // то же правило, что в TBasicEngine::RefreshWinLoseState
+        const bool win = max_tiles[i] >= win_tile;
+        const bool lose = empty_counts[i] == 0 && !boards[i].HasEqualNeighbours();
+        dones[i] = (win && !keep_playing_flag) || lose;
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        if (dones[i]) {
+            Reset(i);
+        }
+    }
+}
+
+template <int X, int Y>
+size_t TBasicEngineBatch<X, Y>::size() const {
+    return boards.size();
+}
+
+template <int X, int Y>
+const typename TBasicEngineBatch<X, Y>::TBoardType &TBasicEngineBatch<X, Y>::GetBoard(size_t i) const {
+    return boards[i];
+}
+
+template <int X, int Y>
+uint32_t TBasicEngineBatch<X, Y>::GetScore(size_t i) const {
+    return scores[i];
+}
+
+template <int X, int Y>
+uint32_t TBasicEngineBatch<X, Y>::GetMoveCount(size_t i) const {
+    return move_counts[i];
+}
+
+template <int X, int Y>
+void TBasicEngineBatch<X, Y>::SetWinTile(EEngineTileType tile) {
+    if (tile <= EEngineTileType::TILE_1 || tile > EEngineTileType::TILE_16384) {
+        throw runtime_error("Wrong win tile");
+    }
+
+    win_tile = tile;
+}
+
+template <int X, int Y>
+void TBasicEngineBatch<X, Y>::SetKeepPlaying(bool keep_playing) {
+    keep_playing_flag = keep_playing;
+}
+
+template class TBasicEngineBatch<3, 3>;
+template class TBasicEngineBatch<4, 4>;
+template class TBasicEngineBatch<5, 5>;
+template class TBasicEngineBatch<6, 6>;
@@ -0,0 +1,58 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <vector>
+
+#include <engine/engine.h>
+
+// TBasicEngineBatch - много независимых партий, которые ходят одновременно
+// состояние разложено по массивам (поля подряд, генераторы, счёт, счётчики), поэтому проход по партиям
+// идёт по памяти подряд, а циклы без таблиц компилятор может векторизовать
+// закончившаяся партия сразу начинается заново, её флаг в dones говорит об этом
+
+template <int X, int Y>
+class TBasicEngineBatch {
+    public:
+        typedef TBasicBoard<X, Y> TBoardType;
+        typedef TBasicEngine<X, Y> TEngineType;
+
+        TBasicEngineBatch(size_t count, uint64_t seed); // партия i использует seed + i
+
+        // один ход в каждой партии; rewards - прирост счёта, dones - 1, если партия закончилась и начата заново
+        // ход, не меняющий поле, пропускается с нулевой наградой
+        void Step(const std::vector<ETurnDirection> &actions, std::vector<uint32_t> &rewards, std::vector<uint8_t> &dones);
+
+        void Reset(size_t i);
+
+        size_t size() const;
+
+        const TBoardType &GetBoard(size_t i) const;
+        uint32_t GetScore(size_t i) const;
+        uint32_t GetMoveCount(size_t i) const;
+
+        // как в TBasicEngine: по умолчанию партия кончается на TILE_2048
+        void SetWinTile(EEngineTileType tile);
+        void SetKeepPlaying(bool keep_playing);
+
+    private:
+        std::vector<TBoardType> boards;
+        std::vector<uint64_t> random_s0, random_s1, random_s2, random_s3; // состояния генераторов по словам
+        std::vector<uint64_t> random_words; // случайные числа текущего хода
+        std::vector<uint32_t> scores;
+        std::vector<uint32_t> move_counts;
+        std::vector<uint8_t> empty_counts;
+        std::vector<EEngineTileType> max_tiles;
+
+        EEngineTileType win_tile;
+        bool keep_playing_flag;
+
+        uint64_t NextRandom(size_t i);
+};
+
+extern template class TBasicEngineBatch<3, 3>;
+extern template class TBasicEngineBatch<4, 4>;
+extern template class TBasicEngineBatch<5, 5>;
+extern template class TBasicEngineBatch<6, 6>;
+
+typedef TBasicEngineBatch<SIZE_OF_FIELD_X, SIZE_OF_FIELD_Y> TEngineBatch;
@@ -0,0 +1,46 @@
+#pragma once
+
+#include <cstdint>
+
+#if defined(__BMI2__)
+#include <immintrin.h>
+#endif
+
+// битовые операции над упакованным полем
+
+inline int PopCount(uint64_t x) {
+#if defined(__GNUC__)
+    return __builtin_popcountll(x);
+#else
+    int result = 0;
+    for (; x; x &= x - 1) {
+        result++;
+    }
+    return result;
+#endif
+}
+
+inline int CountTrailingZeros(uint64_t x) {
+    // x != 0
+#if defined(__GNUC__)
+    return __builtin_ctzll(x);
+#else
+    int result = 0;
+    for (; !(x & 1); x >>= 1) {
+        result++;
+    }
+    return result;
+#endif
+}
+
+inline int SelectBit(uint64_t mask, int k) {
+    // номер k-го (с нуля) установленного бита mask, k < PopCount(mask)
+#if defined(__BMI2__)
+    return CountTrailingZeros(_pdep_u64(uint64_t(1) << k, mask));
+#else
+    for (; k > 0; k--) {
+        mask &= mask - 1;
+    }
+    return CountTrailingZeros(mask);
+#endif
+}
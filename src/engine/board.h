@@ -0,0 +1,338 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+#include <vector>
+#include <functional>
+#include <assert.h>
+
+#include <engine/bits.h>
+
+// TBasicBoard - упакованное поле X на Y, по 4 бита (показатель тайла) на клетку
+// строка занимает 4 * Y бит, строки целиком укладываются в 64-битные слова:
+// поля 3x3 и 4x4 - одно слово, 5x5 - два, 6x6 - три
+
+enum EEngineSettings {
+    TILES_AT_START = 2,
+    HISTORY_SIZE = 256, // сколько позиций хранится для отмены ходов
+    SIZE_OF_FIELD_X = 4, // размер поля игры в окне
+    SIZE_OF_FIELD_Y = 4
+};
+
+enum class EEngineTileType : uint8_t {
+    TILE_0,
+    TILE_1,
+    TILE_2,
+    TILE_4,
+    TILE_8,
+    TILE_16,
+    TILE_32,
+    TILE_64,
+    TILE_128,
+    TILE_256,
+    TILE_512,
+    TILE_1024,
+    TILE_2048,
+    TILE_4096,
+    TILE_8192,
+    TILE_16384, // больше в 4 бита не помещается, два таких тайла не объединяются
+};
+
+template <int X, int Y>
+class TBasicBoard {
+    static_assert(X >= 2 && Y >= 2 && X <= 8 && Y <= 8, "field sizes from 2 to 8 are supported");
+
+    public:
+        enum {
+            ROW_BITS = 4 * Y,
+            ROWS_PER_WORD = 64 / ROW_BITS,
+            WORDS = (X + ROWS_PER_WORD - 1) / ROWS_PER_WORD
+        };
+
+        TBasicBoard();
+        explicit TBasicBoard(uint64_t raw); // только для полей в одно слово
+        TBasicBoard(const std::vector<std::vector<EEngineTileType>> &field);
+
+        EEngineTileType operator()(int x, int y) const; // возвращение тайла
+        void Set(int x, int y, EEngineTileType tile);
+
+        int GetXSize() const;
+        int GetYSize() const;
+
+        // строка x - 4 * Y бит, клетка (x, y) лежит в битах 4 * y строки
+        uint32_t GetRow(int x) const;
+        void SetRow(int x, uint32_t row);
+
+        uint64_t GetRaw() const; // только для полей в одно слово
+        uint64_t GetWord(int i) const;
+
+        // младший бит каждой пустой клетки установлен, остальные сброшены; только для полей в одно слово
+        uint64_t GetEmptyCells() const;
+        int CountEmpty() const;
+        int FindEmpty(int k) const; // номер x * Y + y k-й (с нуля) пустой клетки
+        bool HasEqualNeighbours() const; // есть ли рядом по горизонтали или вертикали два одинаковых тайла, которые можно объединить
+        EEngineTileType GetMaxTile() const;
+
+        TBasicBoard<Y, X> Transpose() const; // столбцы становятся строками
+
+        bool operator==(const TBasicBoard &other) const;
+        bool operator!=(const TBasicBoard &other) const;
+
+    private:
+        std::array<uint64_t, WORDS> words;
+
+        static constexpr uint64_t ONES = 0x1111111111111111ULL;
+        static constexpr uint64_t HIGHS = 0x8888888888888888ULL;
+        static constexpr uint64_t ROW_MASK = (uint64_t(1) << ROW_BITS) - 1;
+
+        static int GetWordIndex(int x);
+        static int GetShift(int x, int y);
+
+        static constexpr uint64_t GetValidMask(int word); // биты клеток слова, которые есть на поле
+        static constexpr uint64_t GetNoRightMask(); // клетки без соседа справа в поле из одного слова
+        static constexpr uint64_t GetNoDownMask(); // клетки без соседа снизу в поле из одного слова
+
+        static uint64_t GetEmptyCells(uint64_t word, int i);
+        static bool HasZeroNibble(uint64_t x);
+        static uint64_t GetMaxCells(uint64_t x); // тетрады 0xF (тайл 16384) заполнены единицами, остальные нулевые
+};
+
+typedef TBasicBoard<SIZE_OF_FIELD_X, SIZE_OF_FIELD_Y> TBoard;
+
+template <int X, int Y>
+inline TBasicBoard<X, Y>::TBasicBoard()
+        : words() {
+}
+
+template <int X, int Y>
+inline TBasicBoard<X, Y>::TBasicBoard(uint64_t raw)
+        : words{{raw}} {
+    static_assert(WORDS == 1, "raw constructor needs a single-word field");
+}
+
+template <int X, int Y>
+TBasicBoard<X, Y>::TBasicBoard(const std::vector<std::vector<EEngineTileType>> &field)
+        : words() {
+    // упаковка произвольной конфигурации поля
+    assert(field.size() == X);
+
+    for (size_t i = 0; i < field.size(); i++) {
+        assert(field[i].size() == Y);
+        for (size_t j = 0; j < field[i].size(); j++) {
+            Set(i, j, field[i][j]);
+        }
+    }
+}
+
+template <int X, int Y>
+inline int TBasicBoard<X, Y>::GetWordIndex(int x) {
+    return x / ROWS_PER_WORD;
+}
+
+template <int X, int Y>
+inline int TBasicBoard<X, Y>::GetShift(int x, int y) {
+    return ROW_BITS * (x % ROWS_PER_WORD) + 4 * y;
+}
+
+template <int X, int Y>
+constexpr uint64_t TBasicBoard<X, Y>::GetValidMask(int word) {
+    const int rows = X - word * ROWS_PER_WORD < ROWS_PER_WORD ? X - word * ROWS_PER_WORD : ROWS_PER_WORD;
+    return rows * ROW_BITS == 64 ? ~uint64_t(0) : (uint64_t(1) << (rows * ROW_BITS)) - 1;
+}
+
+template <int X, int Y>
+constexpr uint64_t TBasicBoard<X, Y>::GetNoRightMask() {
+    uint64_t result = ~GetValidMask(0);
+    for (int x = 0; x < ROWS_PER_WORD; x++) {
+        result |= uint64_t(0xF) << (ROW_BITS * x + 4 * (Y - 1));
+    }
+    return result;
+}
+
+template <int X, int Y>
+constexpr uint64_t TBasicBoard<X, Y>::GetNoDownMask() {
+    return ~GetValidMask(0) | (GetValidMask(0) & ~(GetValidMask(0) >> ROW_BITS));
+}
+
+template <int X, int Y>
+inline EEngineTileType TBasicBoard<X, Y>::operator()(int x, int y) const {
+    return static_cast<EEngineTileType>((words[GetWordIndex(x)] >> GetShift(x, y)) & 0xF);
+}
+
+template <int X, int Y>
+inline void TBasicBoard<X, Y>::Set(int x, int y, EEngineTileType tile) {
+    uint64_t &word = words[GetWordIndex(x)];
+    const int shift = GetShift(x, y);
+    word = (word & ~(uint64_t(0xF) << shift)) | (uint64_t(static_cast<int>(tile)) << shift);
+}
+
+template <int X, int Y>
+inline int TBasicBoard<X, Y>::GetXSize() const {
+    return X;
+}
+
+template <int X, int Y>
+inline int TBasicBoard<X, Y>::GetYSize() const {
+    return Y;
+}
+
+template <int X, int Y>
+inline uint32_t TBasicBoard<X, Y>::GetRow(int x) const {
+    return static_cast<uint32_t>((words[GetWordIndex(x)] >> GetShift(x, 0)) & ROW_MASK);
+}
+
+template <int X, int Y>
+inline void TBasicBoard<X, Y>::SetRow(int x, uint32_t row) {
+    uint64_t &word = words[GetWordIndex(x)];
+    const int shift = GetShift(x, 0);
+    word = (word & ~(ROW_MASK << shift)) | (uint64_t(row) << shift);
+}
+
+template <int X, int Y>
+inline uint64_t TBasicBoard<X, Y>::GetRaw() const {
+    static_assert(WORDS == 1, "GetRaw needs a single-word field");
+    return words[0];
+}
+
+template <int X, int Y>
+inline uint64_t TBasicBoard<X, Y>::GetWord(int i) const {
+    return words[i];
+}
+
+template <int X, int Y>
+inline uint64_t TBasicBoard<X, Y>::GetEmptyCells(uint64_t word, int i) {
+    uint64_t x = word;
+    x |= x >> 2;
+    x |= x >> 1;
+    return ~x & ONES & GetValidMask(i);
+}
+
+template <int X, int Y>
+inline uint64_t TBasicBoard<X, Y>::GetEmptyCells() const {
+    static_assert(WORDS == 1, "GetEmptyCells needs a single-word field");
+    return GetEmptyCells(words[0], 0);
+}
+
+template <int X, int Y>
+inline int TBasicBoard<X, Y>::CountEmpty() const {
+    int result = 0;
+    for (int i = 0; i < WORDS; i++) {
+        result += PopCount(GetEmptyCells(words[i], i));
+    }
+    return result;
+}
+
+template <int X, int Y>
+inline int TBasicBoard<X, Y>::FindEmpty(int k) const {
+    // внутри слова номер тетрады совпадает с номером клетки, слова идут подряд
+    for (int i = 0; i < WORDS; i++) {
+        const uint64_t empty_cells = GetEmptyCells(words[i], i);
+        const int count = PopCount(empty_cells);
+        if (k < count) {
+            return i * ROWS_PER_WORD * Y + SelectBit(empty_cells, k) / 4;
+        }
+        k -= count;
+    }
+    return -1;
+}
+
+template <int X, int Y>
+inline bool TBasicBoard<X, Y>::HasZeroNibble(uint64_t x) {
+    return (x - ONES) & ~x & HIGHS;
+}
+
+template <int X, int Y>
+inline uint64_t TBasicBoard<X, Y>::GetMaxCells(uint64_t x) {
+    return (x & (x >> 1) & (x >> 2) & (x >> 3) & ONES) * 0xF;
+}
+
+template <int X, int Y>
+inline bool TBasicBoard<X, Y>::HasEqualNeighbours() const {
+    // соседние клетки равны, если их xor - нулевая тетрада
+    // тетрады без соседа справа (последний столбец) и снизу (последняя строка) заполняются единицами
+    // как и клетки с 16384: два таких тайла ядро хода не объединяет, для пары достаточно проверить одну клетку
+    if constexpr (WORDS == 1) {
+        const uint64_t cells = words[0];
+        const uint64_t max_cells = GetMaxCells(cells);
+        const uint64_t horizontal = (cells ^ (cells >> 4)) | GetNoRightMask() | max_cells;
+        const uint64_t vertical = (cells ^ (cells >> ROW_BITS)) | GetNoDownMask() | max_cells;
+
+        return HasZeroNibble(horizontal) | HasZeroNibble(vertical);
+    } else {
+        // строки из разных слов сравниваются по одной
+        const uint64_t no_right = ~ROW_MASK | (uint64_t(0xF) << (4 * (Y - 1)));
+
+        bool result = false;
+        for (int x = 0; x < X; x++) {
+            const uint64_t row = GetRow(x);
+            const uint64_t max_cells = GetMaxCells(row);
+            result |= HasZeroNibble((row ^ (row >> 4)) | no_right | max_cells);
+            if (x + 1 < X) {
+                result |= HasZeroNibble((row ^ GetRow(x + 1)) | ~ROW_MASK | max_cells);
+            }
+        }
+        return result;
+    }
+}
+
+template <int X, int Y>
+inline EEngineTileType TBasicBoard<X, Y>::GetMaxTile() const {
+    int result = 0;
+    for (uint64_t word : words) {
+        for (uint64_t x = word; x; x >>= 4) {
+            if (int(x & 0xF) > result) {
+                result = x & 0xF;
+            }
+        }
+    }
+    return static_cast<EEngineTileType>(result);
+}
+
+template <int X, int Y>
+inline TBasicBoard<Y, X> TBasicBoard<X, Y>::Transpose() const {
+    if constexpr (X == 4 && Y == 4) {
+        // транспонирование без циклов: сначала меняются местами клетки внутри блоков 2x2, затем сами блоки
+        const uint64_t cells = words[0];
+        const uint64_t a1 = cells & 0xF0F00F0FF0F00F0FULL;
+        const uint64_t a2 = cells & 0x0000F0F00000F0F0ULL;
+        const uint64_t a3 = cells & 0x0F0F00000F0F0000ULL;
+        const uint64_t a = a1 | (a2 << 12) | (a3 >> 12);
+
+        const uint64_t b1 = a & 0xFF00FF0000FF00FFULL;
+        const uint64_t b2 = a & 0x00FF00FF00000000ULL;
+        const uint64_t b3 = a & 0x00000000FF00FF00ULL;
+        return TBasicBoard<Y, X>(b1 | (b2 >> 24) | (b3 << 24));
+    } else {
+        TBasicBoard<Y, X> result;
+        for (int x = 0; x < X; x++) {
+            for (int y = 0; y < Y; y++) {
+                result.Set(y, x, (*this)(x, y));
+            }
+        }
+        return result;
+    }
+}
+
+template <int X, int Y>
+inline bool TBasicBoard<X, Y>::operator==(const TBasicBoard &other) const {
+    return words == other.words;
+}
+
+template <int X, int Y>
+inline bool TBasicBoard<X, Y>::operator!=(const TBasicBoard &other) const {
+    return words != other.words;
+}
+
+namespace std {
+    template<int X, int Y>
+    struct hash<TBasicBoard<X, Y>> {
+        size_t operator()(const TBasicBoard<X, Y> &board) const {
+            size_t result = 0;
+            for (int i = 0; i < TBasicBoard<X, Y>::WORDS; i++) {
+                result = result * 31 + hash<uint64_t>()(board.GetWord(i));
+            }
+            return result;
+        }
+    };
+}
@@ -8,288 +8,259 @@
 #include <assert.h>
 
 #include <cstdlib>
-#include <ctime>
 
 #include "engine.h"
+#include "tables.h"
+#include "bits.h"
 
 using namespace std;
 
 
-void TEngine::AddTile(int x, int y, EEngineTileType tile) {
-    if (state[x][y] == EEngineTileType::TILE_0) {
-        state[x][y] = tile;
-    } else {
-        throw runtime_error("Tried to add tile on the tile");
+template <int R, int W>
+static TBasicBoard<R, W> MoveRows(const TBasicBoard<R, W> &board, bool reverse_flag, TMoveSummary &summary) {
+    // сдвиг всех строк к клетке 0 или к последней: по одному вызову ядра строки на строку
+    typedef TRowKernel<W> TKernel;
+    
+    TBasicBoard<R, W> moved;
+    int max_tile = static_cast<int>(summary.max_tile);
+    
+    for (int i = 0; i < R; i++) {
+        const typename TKernel::TMove &move = TKernel::Move(board.GetRow(i), reverse_flag);
+        
+        moved.SetRow(i, move.row);
+        summary.merges += PopCount(move.moves & TKernel::TMove::NEW_TILES_MASK);
+        summary.score += move.score;
+        max_tile = max(max_tile, int(move.max_tile));
+    }
+    
+    summary.max_tile = static_cast<EEngineTileType>(max_tile);
+    
+    return moved;
+}
+
+template <int R, int W>
+static int LegalRows(const TBasicBoard<R, W> &board) {
+    // флаги ERowLegalFlags, объединённые по всем строкам
+    int result = 0;
+    for (int i = 0; i < R; i++) {
+        result |= TRowKernel<W>::Legal(board.GetRow(i));
     }
+    return result;
 }
 
-pair<int, int> TEngine::AddRandomTile(bool only_2 = false) {
-    vector<pair<int, int>> free_cells;
+template <int X, int Y>
+int TBasicEngine<X, Y>::SpawnTile(TBoardType &board, uint64_t random_word, bool only_2) {
+    // ставит 2 или 4 в случайную пустую клетку, случайность берётся из random_word
+    // старшие 32 бита выбирают клетку, младшие - тайл
+    // return номер клетки x * Y + y или -1, если пустых клеток нет
+    const int count = board.CountEmpty();
     
-    for (int i = 0; i < GetXSize(); i++) {
-        for (int j = 0; j < GetYSize(); j++) {
-            if (state[i][j] == EEngineTileType::TILE_0) {
-                free_cells.push_back(make_pair(i, j));
-            }
-        }
+    if (count == 0) {
+        return -1;
     }
     
+    const int number = static_cast<int>(((random_word >> 32) * count) >> 32);
+    const int cell = board.FindEmpty(number);
+    
+    // с вероятностью 10% тайл 4
+    const bool four = !only_2 && ((random_word & 0xFFFFFFFF) * 10 >> 32) == 0;
     
-    if (free_cells.size() == 0) {
+    board.Set(cell / Y, cell % Y, four ? EEngineTileType::TILE_4 : EEngineTileType::TILE_2);
+    
+    return cell;
+}
+
+template <int X, int Y>
+pair<int, int> TBasicEngine<X, Y>::AddRandomTile(bool only_2, uint64_t random_word) {
+    const int cell = SpawnTile(state.board, random_word, only_2);
+    
+    if (cell < 0) {
         throw runtime_error("can't add new tile");
-    } else {
-        int random_number = rand() % free_cells.size();
-        
-        auto random_cell = free_cells[random_number];
-        
-        int x = random_cell.first;
-        int y = random_cell.second;
-        
-        if (!only_2 && !(rand() % 10)) { // с вероятностью 10% тайл 4
-            AddTile(x, y, EEngineTileType::TILE_4);
-        } else {
-            AddTile(x, y, EEngineTileType::TILE_2);
-        }
-        return make_pair(x, y);
     }
     
+    state.empty_count--;
+    state.max_tile = max(state.max_tile, state.board(cell / Y, cell % Y));
+    
+    return make_pair(cell / Y, cell % Y);
 }
 
-EEngineTileType TEngine::GetDoubleTile(EEngineTileType tile) {
-    // возвращает удвоенный тайл
+template <int X, int Y>
+EEngineTileType TBasicEngine<X, Y>::GetDoubleTile(EEngineTileType tile) {
+    // возвращает удвоенный тайл; TILE_16384 не объединяется, поэтому переполнения нет
+    assert(tile < EEngineTileType::TILE_16384);
+    
     return static_cast <EEngineTileType> (static_cast <int> (tile) + 1);
 }
 
-EEngineTileType TEngine::GetWinTile() {
-    // выигрышный тайл
-    //return EEngineTileType::TILE_32;
-    return EEngineTileType::TILE_2048;
+template <int X, int Y>
+EEngineTileType TBasicEngine<X, Y>::GetWinTile() const {
+    return state.win_tile;
 }
 
-vector<EEngineTileType> TEngine::GetLine(bool vertical, int line_number) const{
-    vector<EEngineTileType> result;
-    if (vertical) {
-        for (int i = 0; i < SIZE_OF_FIELD_Y; i++) {
-            result.push_back(state[i][line_number]);
-        }
-    } else {
-        for (int i = 0; i < SIZE_OF_FIELD_X; i++) {
-            result.push_back(state[line_number][i]);
-        }
+template <int X, int Y>
+void TBasicEngine<X, Y>::SetWinTile(EEngineTileType tile) {
+    // выигрышный тайл
+    //win_tile = EEngineTileType::TILE_32;
+    if (tile <= EEngineTileType::TILE_1 || tile > EEngineTileType::TILE_16384) {
+        throw runtime_error("Wrong win tile");
     }
     
-    return result;
+    state.win_tile = tile;
+    RefreshWinLoseState();
 }
 
-void TEngine::WriteLine(bool vertical, int line_number, const vector<EEngineTileType> &new_line) {
-    if (vertical) {
-        assert(new_line.size() == SIZE_OF_FIELD_Y);
-    } else {
-        assert(new_line.size() == SIZE_OF_FIELD_X);
-    }
-    
-    for (int i = 0; i < new_line.size(); i++) {
-        if (vertical) {
-            state[i][line_number] = new_line[i];
-        } else {
-            state[line_number][i] = new_line[i];
-        }
-    }
+template <int X, int Y>
+bool TBasicEngine<X, Y>::GetKeepPlaying() const {
+    return state.keep_playing_flag;
 }
 
+template <int X, int Y>
+void TBasicEngine<X, Y>::SetKeepPlaying(bool keep_playing) {
+    state.keep_playing_flag = keep_playing;
+    RefreshWinLoseState();
+}
 
-void TEngine::Transpose(TShiftOfTile &s) {
+template <int X, int Y>
+void TBasicEngine<X, Y>::Transpose(TShiftOfTile &s) {
     swap(s.x_old, s.y_old);
     swap(s.x_new, s.y_new);
 }
 
-bool TEngine::MakeTurnLine(bool vertical, int line_number, ETurnDirection turn, vector<TShiftOfTile> &shifts, vector<SNewTile> &appear_tiles) {
-    // делает ход на одной линии
-    // return true если что-то изменилось
-    // shifts - вектор сдвигов, какой тайл в какую позицию
-    
-    const int line_size = vertical ? SIZE_OF_FIELD_Y : SIZE_OF_FIELD_X;
-    
-    const bool reverse_flag = !((turn == ETurnDirection::LEFT) || (turn == ETurnDirection::UP));
-    
-    vector<EEngineTileType> current_line = GetLine(vertical, line_number), new_line;
-
-    if (reverse_flag) {
-        reverse(begin(current_line), end(current_line));
-    }
+template <int X, int Y>
+template <int W>
+void TBasicEngine<X, Y>::DescribeTurnLine(uint32_t row, int line_number, bool vertical, bool reverse_flag, TTurnResultType &turn_result) {
+    // восстанавливает сдвиги одной строки из W клеток по ядру строки
+    // turn_result.shifts - сдвиги, какой тайл в какую позицию
+    // для вертикального хода row - столбец, line_number - его номер
+    typedef TRowKernel<W> TKernel;
+    typedef typename TKernel::TMove TMove;
     
-    auto previous = EEngineTileType::TILE_0; // последний встреченный ненулевой тайл
-    int previous_position = -1; // его позиция
-        
-    bool is_tile_before = false;
-    
-    bool changed = false; // true если произошли изменения
-    
-    bool after_free_space = false; // true если после пустых клеток
+    const TMove &move = TKernel::Move(row, reverse_flag);
     
-    int start_i;
-    
-    for (int i = 0; i < current_line.size(); i++) {
-        auto val = current_line[i];
+    // сдвиги перечисляются в порядке обхода от стенки, к которой идёт ход
+    for (int i = 0; i < W; i++) {
+        const int position = reverse_flag ? W - i - 1 : i;
+        const auto val = static_cast<EEngineTileType>((row >> (4 * position)) & 0xF);
         
         if (val == EEngineTileType::TILE_0) {
-            after_free_space = true;
             continue;
-        } else {
-            if (after_free_space) {
-                changed = true; // изменения произошли если встретился ненулевой за нулевым
-                after_free_space = false;
-            }
-            if (val == previous) { // если объединяется с предыдущим
-                new_line.push_back(GetDoubleTile(previous));
-                previous = EEngineTileType::TILE_0;
-                is_tile_before = false;
-                changed = true;
-                
-                int new_coordinate = new_line.size() - 1;
-                
-                TShiftOfTile t1, t2; // t1 - предыдущий тайл, t2 последний
-                // по умолчанию по горизонтали, если по вертикали, меняет
-                t1.y_old = t1.y_new = t2.y_old = t2.y_new = line_number;
-                t1.x_old = previous_position;
-                t1.x_new = new_coordinate;
-                
-                t2.x_old = i;
-                t2.x_new = new_coordinate;
-                
-                t1.type = t2.type = val;
-                t1.unite_flag = t2.unite_flag = true;
-                
-                int cells_to_appear = max(abs(t1.x_old - t1.x_new), abs(t2.x_old - t2.x_new)); // сколько клеток должно пройти, чтобы закончилось движение
-                
-                if (reverse_flag) {
-                    t1.x_old = line_size - t1.x_old - 1;
-                    t2.x_old = line_size - t2.x_old - 1;
-                    t1.x_new = line_size - t1.x_new - 1;
-                    t2.x_new = line_size - t2.x_new - 1;
-                }
-                
-                if (vertical) {
-                    Transpose(t1);
-                    Transpose(t2);
-                }
-                
-                shifts.push_back(t1);
-                shifts.push_back(t2);
-                
-                
-                SNewTile new_tile({t2.x_new, t2.y_new, GetDoubleTile(val), cells_to_appear});
-                
-                appear_tiles.push_back(new_tile);
-                
-            } else { // если не объединяется с предыдущим
-                if (is_tile_before) {
-                    new_line.push_back(previous);
-
-                    int new_coordinate = new_line.size() - 1;
-                    
-                    TShiftOfTile t; 
-                    
-                    t.y_old = t.y_new = line_number;
-                    t.x_old = previous_position;
-                    t.x_new = new_coordinate;
-                    
-                    t.type = previous;
-                    //t.unite_flag = true;
-                    
-                    if (reverse_flag) {
-                        t.x_old = line_size - t.x_old - 1;
-                        t.x_new = line_size - t.x_new - 1;
-                    }
-                    
-                    if (vertical) {
-                        Transpose(t);
-                    }
-                    
-                    shifts.push_back(t);
-                }
-                
-                previous = val;
-                previous_position = i;
-                
-                is_tile_before = true;
-            }
         }
-    }
-    
-    if (previous != EEngineTileType::TILE_0) {
-        new_line.push_back(previous);
         
-        int new_coordinate = new_line.size() - 1;
+        const auto info = (move.moves >> (TMove::MOVE_BITS * position)) & ((1 << TMove::MOVE_BITS) - 1);
+        const int new_position = info & TMove::POSITION_MASK;
         
-        TShiftOfTile t; // t1 - предыдущий тайл, t2 последний
-                    // по умолчанию по горизонтали, если по вертикали, меняет
+        TShiftOfTile t; // по умолчанию по горизонтали, если по вертикали, меняет
         t.y_old = t.y_new = line_number;
-        t.x_old = previous_position;
-        t.x_new = new_coordinate;
-        
-        t.type = previous;
-        
-        if (reverse_flag) {
-            t.x_old = line_size - t.x_old - 1;
-            t.x_new = line_size - t.x_new - 1;
-        }
+        t.x_old = position;
+        t.x_new = new_position;
+        t.type = val;
+        t.unite_flag = info & TMove::UNITE;
         
         if (vertical) {
             Transpose(t);
         }
         
-        shifts.push_back(t);
+        turn_result.shifts.push_back(t);
+        
+        if (info & TMove::NEW_TILE) { // второй тайл пары прошёл больше клеток, чем первый
+            int cells_to_appear = abs(position - new_position);
+            
+            SNewTile new_tile({t.x_new, t.y_new, GetDoubleTile(val), cells_to_appear});
+            
+            turn_result.new_tiles.push_back(new_tile);
+        }
     }
+}
+
+template <int X, int Y>
+typename TBasicEngine<X, Y>::TTurnResultType TBasicEngine<X, Y>::DescribeTurn(const TBoardType &before, ETurnDirection turn) {
+    // сдвиги и новые тайлы хода turn из позиции before, нужны только для анимации
+    const bool vertical = (turn == ETurnDirection::UP) || (turn == ETurnDirection::DOWN);
+    const bool reverse_flag = (turn == ETurnDirection::RIGHT) || (turn == ETurnDirection::DOWN);
     
-    int need_to_add = line_size - new_line.size();
-    for (int i = 0; i < need_to_add; i++) {
-        new_line.push_back(EEngineTileType::TILE_0);
-    }
+    TTurnResultType turn_result;
     
-    if (reverse_flag) {
-        reverse(begin(new_line), end(new_line));
+    if (vertical) { // столбцы транспонированного поля - строки длины X
+        const TBasicBoard<Y, X> columns = before.Transpose();
+        for (int i = 0; i < Y; i++) {
+            DescribeTurnLine<X>(columns.GetRow(i), i, true, reverse_flag, turn_result);
+        }
+    } else {
+        for (int i = 0; i < X; i++) {
+            DescribeTurnLine<Y>(before.GetRow(i), i, false, reverse_flag, turn_result);
+        }
     }
     
-    WriteLine(vertical, line_number, new_line);
+    return turn_result;
+}
+
+template <int X, int Y>
+typename TBasicEngine<X, Y>::TBoardType TBasicEngine<X, Y>::MoveBoard(const TBoardType &board, ETurnDirection turn) {
+    TMoveSummary summary;
+    return MoveBoard(board, turn, summary);
+}
+
+template <int X, int Y>
+typename TBasicEngine<X, Y>::TBoardType TBasicEngine<X, Y>::MoveBoard(const TBoardType &board, ETurnDirection turn, TMoveSummary &summary) {
+    // результат хода без новых тайлов
+    const bool reverse_flag = (turn == ETurnDirection::RIGHT) || (turn == ETurnDirection::DOWN);
     
-    return changed;
+    // вертикальный ход - это горизонтальный ход на транспонированном поле
+    if ((turn == ETurnDirection::UP) || (turn == ETurnDirection::DOWN)) {
+        return MoveRows(board.Transpose(), reverse_flag, summary).Transpose();
+    } else {
+        return MoveRows(board, reverse_flag, summary);
+    }
 }
 
-TEngine::TEngine()
-        : state(vector<vector<EEngineTileType>> (SIZE_OF_FIELD_X, vector<EEngineTileType>(SIZE_OF_FIELD_Y, EEngineTileType::TILE_0)))
-        , win_flag(false)
-        , lose_flag(false) {
+template <int X, int Y>
+TBasicEngine<X, Y>::TBasicEngine()
+        : TBasicEngine(TRandom::MakeSeed()) {
+}
 
-    srand(time(NULL));
+template <int X, int Y>
+TBasicEngine<X, Y>::TBasicEngine(uint64_t seed)
+        : state{TBoardType(), TRandom(seed), 0, 0, X * Y, EEngineTileType::TILE_0, EEngineTileType::TILE_2048, false, false, false} {
+    // одинаковый seed даёт одинаковую партию при одинаковых ходах
     
     InitializeField();
     
     RefreshWinLoseState();
 }
 
-TEngine::TEngine(const vector<vector<EEngineTileType>> &field)
-        : state(vector<vector<EEngineTileType>> (SIZE_OF_FIELD_X, vector<EEngineTileType>(SIZE_OF_FIELD_Y, EEngineTileType::TILE_0)))
-        , win_flag(false)
-        , lose_flag(false) {
-    // конструктор произвольной конфигурации поля
-    
-    assert(field.size() == GetXSize());
-    for (auto val : field) {
-        assert(val.size() == GetYSize());
-    }
-    
-    for (size_t i = 0; i < field.size(); i++) {
-        for (size_t j = 0; j < field[i].size(); j++) {
-            state[i][j] = field[i][j];
-        }
-    }
+template <int X, int Y>
+TBasicEngine<X, Y>::TBasicEngine(const vector<vector<EEngineTileType>> &field)
+        : TBasicEngine(field, TRandom::MakeSeed()) {
+}
+
+template <int X, int Y>
+TBasicEngine<X, Y>::TBasicEngine(const vector<vector<EEngineTileType>> &field, uint64_t seed)
+        : state{TBoardType(field), TRandom(seed), 0, 0, 0, EEngineTileType::TILE_0, EEngineTileType::TILE_2048, false, false, false} {
+    // конструктор произвольной конфигурации поля, упаковывает его в TBasicBoard
     
+    RecountTiles();
     RefreshWinLoseState();
 }
 
 
-void TEngine::InitializeField() {
+template <int X, int Y>
+TBasicEngine<X, Y>::TBasicEngine(const TStateType &snapshot)
+        : state(snapshot) {
+}
+
+template <int X, int Y>
+typename TBasicEngine<X, Y>::TStateType TBasicEngine<X, Y>::Snapshot() const {
+    return state;
+}
+
+template <int X, int Y>
+void TBasicEngine<X, Y>::Restore(const TStateType &snapshot) {
+    state = snapshot;
+}
+
+
+template <int X, int Y>
+void TBasicEngine<X, Y>::InitializeField() {
     // инициализирует поле
     /*state[2][3] = EEngineTileType::TILE_32;
     state[0][0] = EEngineTileType::TILE_2;
@@ -304,114 +275,190 @@ void TEngine::InitializeField() {
     
     
     for (int i = 0; i < TILES_AT_START; i++) {
-        AddRandomTile(true); // добавляем только двойки на старте 
+        AddRandomTile(true, state.random.Next()); // добавляем только двойки на старте 
     }
 }
 
-bool TEngine::IsEnd() const {
-    // произошёл ли конец игры
-    return win_flag || lose_flag;
+template <int X, int Y>
+bool TBasicEngine<X, Y>::IsEnd() const {
+    // произошёл ли конец игры; в режиме продолжения выигрыш её не заканчивает
+    return (state.win_flag && !state.keep_playing_flag) || state.lose_flag;
+}
+
+template <int X, int Y>
+bool TBasicEngine<X, Y>::IsWin() const {
+    return state.win_flag;
+}
+
+template <int X, int Y>
+bool TBasicEngine<X, Y>::IsLose() const {
+    return state.lose_flag;
 }
 
-bool TEngine::IsWin() const {
-    return win_flag;
+template <int X, int Y>
+uint32_t TBasicEngine<X, Y>::GetScore() const {
+    return state.score;
 }
 
-bool TEngine::IsLose() const {
-    return lose_flag;
+template <int X, int Y>
+uint32_t TBasicEngine<X, Y>::GetMoveCount() const {
+    return state.move_count;
 }
 
-void TEngine::RefreshWinLoseState() {
+template <int X, int Y>
+void TBasicEngine<X, Y>::RecountTiles() {
+    // полный пересчёт, нужен только при создании движка
+    state.empty_count = state.board.CountEmpty();
+    state.max_tile = state.board.GetMaxTile();
+}
+
+template <int X, int Y>
+void TBasicEngine<X, Y>::RefreshWinLoseState() {
+    // O(1): наибольший тайл и число пустых клеток уже известны
     // если появился выигрышный тайл, выигрыш независимо от возможности хода
-    bool has_free_space = false;
-    for (int i = 0; i < GetXSize(); i++) {
-        for (int j = 0; j < GetYSize(); j++) {
-            auto tile = (*this)(i, j);
-            if (tile == GetWinTile()) {
-                win_flag = true;
-            }
-            
-            if (tile == EEngineTileType::TILE_0) {
-                has_free_space = true;
-            }
-        }
-    }
+    // наибольший тайл не уменьшается, поэтому флаг можно пересчитывать на каждом ходе
+    state.win_flag = state.max_tile >= state.win_tile;
     
-    if (!win_flag && !has_free_space) { // если есть вероятность проигрыша
-        lose_flag = true;
-        
-        for (int i = 1; i < GetXSize() - 1; i++) {
-            for (int j = 1; j < GetYSize() - 1; j++) {
-                // проверяем, можно ли успешно сдвинуть
-                auto tile = (*this)(i, j);
-                auto t1 = (*this)(i + 1, j);
-                auto t2 = (*this)(i, j + 1);
-                auto t3 = (*this)(i - 1, j);
-                auto t4 = (*this)(i, j - 1);
-                
-                if (tile == t1 || tile == t2 ||
-                    tile == t3 || tile == t4) {
-                        lose_flag = false;
-                        break;
-                }
-            }
-            
-            if (!lose_flag) {
-                break;
-            }
-        }
-    }
+    // без пустых клеток ход возможен, только если рядом есть одинаковые тайлы (в том числе у края)
+    // после выигрыша проигрыш возможен только в режиме продолжения
+    state.lose_flag = (!state.win_flag || state.keep_playing_flag) && state.empty_count == 0 && !state.board.HasEqualNeighbours();
 }
 
-optional<pair<vector<TShiftOfTile>, vector<SNewTile>>> TEngine::MakeTurn(ETurnDirection turn) {
-    // делает один ход, без создания новых тайлов
+template <int X, int Y>
+int TBasicEngine<X, Y>::LegalMoves(const TBoardType &board) {
+    // все четыре направления за один проход: по обращению к ядру на каждую строку и каждый столбец
+    const int horizontal = LegalRows(board);
+    const int vertical = LegalRows(board.Transpose());
+    
+    return (horizontal & ROW_LEGAL_LEFT) << static_cast<int>(ETurnDirection::LEFT)
+         | (horizontal & ROW_LEGAL_RIGHT) >> 1 << static_cast<int>(ETurnDirection::RIGHT)
+         | (vertical & ROW_LEGAL_LEFT) << static_cast<int>(ETurnDirection::UP)
+         | (vertical & ROW_LEGAL_RIGHT) >> 1 << static_cast<int>(ETurnDirection::DOWN);
+}
+
+template <int X, int Y>
+int TBasicEngine<X, Y>::LegalMoves() const {
+    // после конца игры ходить нельзя
+    return IsEnd() ? 0 : LegalMoves(state.board);
+}
+
+template <int X, int Y>
+bool TBasicEngine<X, Y>::ApplyMove(ETurnDirection turn) {
+    // делает один ход, без создания новых тайлов и без сведений для анимации
+    // return true если что-то изменилось
     if (!IsEnd()) {
-        bool vertical = (turn == ETurnDirection::UP) || (turn == ETurnDirection::DOWN);
-        
-        int lim;
-        if (vertical) {
-            lim = SIZE_OF_FIELD_X; // количество столбцов
-        } else {
-            lim = SIZE_OF_FIELD_Y; // количество строк 
-        }
-        
-        bool result = false;
+        TMoveSummary summary;
+        const TBoardType moved = MoveBoard(state.board, turn, summary);
+        const bool result = moved != state.board;
         
-        vector<TShiftOfTile> shifts;
-        vector<SNewTile> new_tiles;
+        state.board = moved;
+        state.empty_count += summary.merges;
+        state.max_tile = max(state.max_tile, summary.max_tile);
+        state.score += summary.score;
+        state.move_count += result;
         
-        for (int i = 0; i < lim; i++) {
-            result = MakeTurnLine(vertical, i, turn, shifts, new_tiles) or result;
-        }    
-        
-        if (result) {
-            return make_optional(make_pair(shifts, new_tiles));
-        } else {
-            return nullopt;
-        }
+        return result;
     } else {
         throw runtime_error("Tried to move when game is finished");
     }
 }
 
-pair<int, int> TEngine::AfterTurn() {
+template <int X, int Y>
+optional<typename TBasicEngine<X, Y>::TTurnResultType> TBasicEngine<X, Y>::MakeTurn(ETurnDirection turn) {
+    // делает один ход, без создания новых тайлов
+    const TBoardType before = state.board;
+    
+    if (ApplyMove(turn)) {
+        return make_optional(DescribeTurn(before, turn));
+    } else {
+        return nullopt;
+    }
+}
+
+template <int X, int Y>
+pair<int, int> TBasicEngine<X, Y>::AfterTurn() {
     // после перемещения - добавляет новый тайл и обновляет состояние
-    auto result = AddRandomTile();
+    return AfterTurn(state.random.Next());
+}
+
+template <int X, int Y>
+pair<int, int> TBasicEngine<X, Y>::AfterTurn(uint64_t random_word) {
+    // то же, но со случайным числом, вытянутым заранее (например, TRandom::Fill на много ходов)
+    auto result = AddRandomTile(false, random_word);
     RefreshWinLoseState();
     return result;
 }
 
-EEngineTileType TEngine::operator()(int x, int y) const {
-    assert(x >= 0 && x <= SIZE_OF_FIELD_X);
-    assert(y >= 0 && y <= SIZE_OF_FIELD_Y);
+template <int X, int Y>
+EEngineTileType TBasicEngine<X, Y>::operator()(int x, int y) const {
+    assert(x >= 0 && x < X);
+    assert(y >= 0 && y < Y);
     
-    return state[x][y];
+    return state.board(x, y);
 }
 
-int TEngine::GetXSize() const {
-    return SIZE_OF_FIELD_X;
+template <int X, int Y>
+int TBasicEngine<X, Y>::GetXSize() const {
+    return state.board.GetXSize();
 }
 
-int TEngine::GetYSize() const {
-    return SIZE_OF_FIELD_Y;
-}
\ No newline at end of file
+template <int X, int Y>
+int TBasicEngine<X, Y>::GetYSize() const {
+    return state.board.GetYSize();
+}
+
+template <int X, int Y>
+uint64_t TBasicEngine<X, Y>::GetSeed() const {
+    return state.random.GetSeed();
+}
+
+template <int X, int Y>
+const typename TBasicEngine<X, Y>::TBoardType &TBasicEngine<X, Y>::GetBoard() const {
+    return state.board;
+}
+
+template <int X, int Y>
+optional<typename TBasicEngineWithHistory<X, Y>::TTurnResultType> TBasicEngineWithHistory<X, Y>::MakeTurn(ETurnDirection turn) {
+    const TStateType before = this->Snapshot();
+    
+    auto result = TBasicEngine<X, Y>::MakeTurn(turn);
+    if (result) {
+        history.Push(before);
+    }
+    return result;
+}
+
+template <int X, int Y>
+bool TBasicEngineWithHistory<X, Y>::Undo(int count) {
+    const auto snapshot = history.Undo(this->Snapshot(), count);
+    if (snapshot) {
+        this->Restore(*snapshot);
+    }
+    return bool(snapshot);
+}
+
+template <int X, int Y>
+bool TBasicEngineWithHistory<X, Y>::Redo(int count) {
+    const auto snapshot = history.Redo(count);
+    if (snapshot) {
+        this->Restore(*snapshot);
+    }
+    return bool(snapshot);
+}
+
+template <int X, int Y>
+int TBasicEngineWithHistory<X, Y>::GetUndoCount() const {
+    return history.GetUndoCount();
+}
+
+template <int X, int Y>
+int TBasicEngineWithHistory<X, Y>::GetRedoCount() const {
+    return history.GetRedoCount();
+}
+
+template class TBasicEngine<3, 3>;
+template class TBasicEngine<4, 4>;
+template class TBasicEngine<5, 5>;
+template class TBasicEngine<6, 6>;
+
+template class TBasicEngineWithHistory<4, 4>;
\ No newline at end of file
@@ -3,14 +3,15 @@
 #include <utility>
 #include <vector>
 #include <optional>
+#include <type_traits>
 
-// TEngine - логика игры
+#include <engine/board.h>
+#include <engine/fixed_vector.h>
+#include <engine/history.h>
+#include <engine/random.h>
 
-enum EEngineSettings {
-    TILES_AT_START = 2,
-    SIZE_OF_FIELD_X = 4,
-    SIZE_OF_FIELD_Y = 4
-};
+// TBasicEngine - логика игры на поле X на Y, TEngine - поле размера из EEngineSettings
+// TBasicEngineWithHistory - то же с отменой и повтором ходов; история хранится отдельно, чтобы копия движка оставалась дешёвой
 
 //const int APPEAR_CONST = 1;
 
@@ -21,23 +22,6 @@ enum class ETurnDirection {
     LEFT
 };
 
-enum class EEngineTileType {
-    TILE_0,
-    TILE_1,
-    TILE_2,
-    TILE_4,
-    TILE_8,
-    TILE_16,
-    TILE_32,
-    TILE_64,
-    TILE_128,
-    TILE_256,
-    TILE_512,
-    TILE_1024,
-    TILE_2048,
-};
-
-
 
 struct TShiftOfTile {
     int x_old, y_old;
@@ -52,46 +36,156 @@ struct SNewTile {
     int cells_to_appear;
 };
 
-class TEngine {
+template <int X, int Y>
+struct TTurnResult {
+    // каждый тайл сдвигается не более одного раза, объединений не больше половины клеток
+    TFixedVector<TShiftOfTile, X * Y> shifts;
+    TFixedVector<SNewTile, X * Y / 2> new_tiles;
+};
+
+typedef TTurnResult<SIZE_OF_FIELD_X, SIZE_OF_FIELD_Y> TEngineTurnResult;
+
+struct TMoveSummary {
+    int merges = 0; // сколько пар тайлов объединилось
+    uint32_t score = 0; // сумма значений получившихся тайлов, берётся из таблицы строк
+    EEngineTileType max_tile = EEngineTileType::TILE_0; // наибольший получившийся при объединении тайл
+};
+
+template <int X, int Y>
+struct TBasicEngineState {
+    // всё, что меняется по ходу партии: копируется одним memcpy, без обращений к куче
+    // для поля 4x4 помещается в одну строку кэша
+    TBasicBoard<X, Y> board;
+    TRandom random;
+    
+    uint32_t score; // сумма значений всех тайлов, получившихся при объединении
+    uint32_t move_count; // сколько ходов изменили поле
+    
+    // поддерживаются при каждом ходе, чтобы не пересчитывать поле
+    uint8_t empty_count;
+    EEngineTileType max_tile;
+    
+    EEngineTileType win_tile;
+    bool win_flag, lose_flag;
+    bool keep_playing_flag;
+};
+
+typedef TBasicEngineState<SIZE_OF_FIELD_X, SIZE_OF_FIELD_Y> TEngineState;
+
+static_assert(std::is_trivially_copyable<TEngineState>::value, "TEngineState must be trivially copyable");
+static_assert(sizeof(TEngineState) <= 64, "TEngineState must fit a cache line");
+
+template <int X, int Y>
+class TBasicEngine {
     public:
-        TEngine();
-        TEngine(const std::vector<std::vector<EEngineTileType>> &field);
+        static constexpr int SIZE_X = X;
+        static constexpr int SIZE_Y = Y;
+        
+        typedef TBasicBoard<X, Y> TBoardType;
+        typedef TTurnResult<X, Y> TTurnResultType;
+        typedef TBasicEngineState<X, Y> TStateType;
+        
+        TBasicEngine();
+        explicit TBasicEngine(uint64_t seed);
+        TBasicEngine(const std::vector<std::vector<EEngineTileType>> &field);
+        TBasicEngine(const std::vector<std::vector<EEngineTileType>> &field, uint64_t seed);
+        explicit TBasicEngine(const TStateType &snapshot);
+        
+        // снимок и восстановление за O(1), например для ветвления в переборе
+        TStateType Snapshot() const;
+        void Restore(const TStateType &snapshot);
         
         void InitializeField();
         
         
-        std::optional<std::pair<std::vector<TShiftOfTile>, std::vector<SNewTile>>> MakeTurn(ETurnDirection turn);
+        std::optional<TTurnResultType> MakeTurn(ETurnDirection turn);
+        bool ApplyMove(ETurnDirection turn); // быстрый ход без сведений для анимации
         std::pair<int, int> AfterTurn();
+        std::pair<int, int> AfterTurn(uint64_t random_word);
+        
+        static TBoardType MoveBoard(const TBoardType &board, ETurnDirection turn);
+        static TBoardType MoveBoard(const TBoardType &board, ETurnDirection turn, TMoveSummary &summary);
+        static TTurnResultType DescribeTurn(const TBoardType &before, ETurnDirection turn);
+        static int SpawnTile(TBoardType &board, uint64_t random_word, bool only_2);
+        
+        // маска ходов, меняющих поле: бит 1 << static_cast<int>(ETurnDirection) на каждый
+        int LegalMoves() const;
+        static int LegalMoves(const TBoardType &board);
         
         EEngineTileType operator()(int x, int y) const; // возвращение тайла
         
         int GetXSize() const;
         int GetYSize() const;
         
+        const TBoardType &GetBoard() const; // упакованное поле, пригодно для хеширования
+        
+        uint64_t GetSeed() const; // по нему партию можно повторить
+        
         bool IsEnd() const;
         
         bool IsWin() const;
         bool IsLose() const;
         
-    private:
-        std::vector<std::vector<EEngineTileType>> state; 
+        uint32_t GetScore() const;
+        uint32_t GetMoveCount() const;
+        
+        // выигрышный тайл задаётся при запуске, по умолчанию TILE_2048
+        void SetWinTile(EEngineTileType tile);
+        EEngineTileType GetWinTile() const;
         
-        bool win_flag, lose_flag;
+        // продолжать партию после выигрыша, пока есть ходы
+        void SetKeepPlaying(bool keep_playing);
+        bool GetKeepPlaying() const;
+        
+    private:
+        TStateType state;
         
         
-        void AddTile(int x, int y, EEngineTileType tile);
-        std::pair<int, int> AddRandomTile(bool only_2);
+        std::pair<int, int> AddRandomTile(bool only_2, uint64_t random_word);
     
         static EEngineTileType GetDoubleTile(EEngineTileType tile);
-        static EEngineTileType GetWinTile();
         
         static void Transpose(TShiftOfTile &s);
         
-        std::vector<EEngineTileType> GetLine(bool vertical, int line_number) const;
-        void WriteLine(bool vertical, int line_number, const std::vector<EEngineTileType> &new_line);
-        
-        bool MakeTurnLine(bool vertical, int line_number, ETurnDirection turn, std::vector<TShiftOfTile> &shifts, std::vector<SNewTile> &appear_tiles);
+        template <int W>
+        static void DescribeTurnLine(uint32_t row, int line_number, bool vertical, bool reverse_flag, TTurnResultType &turn_result);
         
+        void RecountTiles();
         void RefreshWinLoseState();
 };
 
+template <int X, int Y>
+class TBasicEngineWithHistory : public TBasicEngine<X, Y> {
+    public:
+        typedef typename TBasicEngine<X, Y>::TTurnResultType TTurnResultType;
+        typedef typename TBasicEngine<X, Y>::TStateType TStateType;
+        
+        using TBasicEngine<X, Y>::TBasicEngine;
+        
+        // запоминает позицию перед ходом для отмены
+        std::optional<TTurnResultType> MakeTurn(ETurnDirection turn);
+        
+        // отмена и повтор count ходов, сделанных через MakeTurn, за O(1)
+        // return false, если столько ходов отменить или повторить нельзя
+        bool Undo(int count = 1);
+        bool Redo(int count = 1);
+        int GetUndoCount() const;
+        int GetRedoCount() const;
+        
+    private:
+        THistory<TStateType, HISTORY_SIZE> history;
+};
+
+// размеры, для которых движок собран в engine.cpp
+extern template class TBasicEngine<3, 3>;
+extern template class TBasicEngine<4, 4>;
+extern template class TBasicEngine<5, 5>;
+extern template class TBasicEngine<6, 6>;
+
+extern template class TBasicEngineWithHistory<4, 4>;
+
+typedef TBasicEngine<SIZE_OF_FIELD_X, SIZE_OF_FIELD_Y> TEngine;
+typedef TBasicEngineWithHistory<SIZE_OF_FIELD_X, SIZE_OF_FIELD_Y> TEngineWithHistory;
+
+// движок копируется в переборе и в каждой партии самоигры, поэтому в нём нет ничего, кроме состояния
+static_assert(sizeof(TEngine) <= 2 * sizeof(TEngineState), "TEngine must stay as cheap to copy as its state");
@@ -0,0 +1,66 @@
+#pragma once
+
+#include <cstddef>
+#include <array>
+#include <assert.h>
+
+// TFixedVector - вектор с фиксированной ёмкостью, хранит элементы внутри себя и не обращается к куче
+
+template <typename T, size_t N>
+class TFixedVector {
+    public:
+        TFixedVector()
+                : count(0) {
+        }
+
+        void push_back(const T &val) {
+            assert(count < N);
+            items[count++] = val;
+        }
+
+        void clear() {
+            count = 0;
+        }
+
+        size_t size() const {
+            return count;
+        }
+
+        bool empty() const {
+            return count == 0;
+        }
+
+        static constexpr size_t capacity() {
+            return N;
+        }
+
+        const T &operator[](size_t i) const {
+            assert(i < count);
+            return items[i];
+        }
+
+        T &operator[](size_t i) {
+            assert(i < count);
+            return items[i];
+        }
+
+        const T *begin() const {
+            return items.data();
+        }
+
+        const T *end() const {
+            return items.data() + count;
+        }
+
+        T *begin() {
+            return items.data();
+        }
+
+        T *end() {
+            return items.data() + count;
+        }
+
+    private:
+        std::array<T, N> items;
+        size_t count;
+};
@@ -0,0 +1,75 @@
+#pragma once
+
+#include <cstddef>
+#include <array>
+#include <optional>
+
+// THistory - история позиций для отмены и повтора ходов
+// кольцевой буфер на N снимков: память ограничена, отменить можно до N - 1 ходов, старые позиции вытесняются новыми
+// позиции нумеруются с начала партии, begin <= cursor <= end, в буфере лежат [begin, end)
+
+template <typename T, size_t N>
+class THistory {
+    static_assert(N >= 2, "history needs room for the current position");
+
+    public:
+        THistory()
+                : begin(0)
+                , cursor(0)
+                , end(0) {
+        }
+
+        void Push(const T &before) {
+            // позиция перед ходом; всё, что можно было повторить, забывается
+            items[cursor % N] = before;
+            end = ++cursor;
+            if (end - begin > N - 1) { // одно место остаётся для текущей позиции при отмене
+                begin = end - (N - 1);
+            }
+        }
+
+        std::optional<T> Undo(const T &current, size_t count) {
+            // позиция на count ходов назад или nullopt, если столько ходов не сохранилось
+            if (count == 0 || count > cursor - begin) {
+                return std::nullopt;
+            }
+
+            if (cursor == end) { // текущая позиция ещё не сохранена, без неё не будет повтора
+                items[cursor % N] = current;
+                end++;
+            }
+
+            cursor -= count;
+            return items[cursor % N];
+        }
+
+        std::optional<T> Redo(size_t count) {
+            // позиция на count ходов вперёд после отмены или nullopt
+            if (count == 0 || cursor + count >= end) {
+                return std::nullopt;
+            }
+
+            cursor += count;
+            return items[cursor % N];
+        }
+
+        size_t GetUndoCount() const {
+            return cursor - begin;
+        }
+
+        size_t GetRedoCount() const {
+            return end > cursor ? end - cursor - 1 : 0;
+        }
+
+        void clear() {
+            begin = cursor = end = 0;
+        }
+
+        static constexpr size_t capacity() {
+            return N;
+        }
+
+    private:
+        std::array<T, N> items;
+        size_t begin, cursor, end;
+};
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <random>
+#include <chrono>
+
+// TRandom - быстрый генератор xoshiro256**, у каждого движка свой
+// состояние заполняется из seed через splitmix64, поэтому партию можно повторить по seed
+
+class TRandom {
+    public:
+        TRandom() = default; // состояние не заполняется, только для массивов снимков
+        explicit TRandom(uint64_t seed);
+
+        uint64_t Next();
+        void Fill(uint64_t *words, size_t count); // заранее вытягивает count чисел, например на много ходов вперёд
+        uint32_t Below(uint32_t limit); // равномерно в [0, limit)
+
+        uint64_t GetSeed() const;
+
+        static uint64_t MakeSeed(); // случайный seed для новой партии
+
+        // шаг генератора над состоянием, разложенным по отдельным переменным,
+        // например по массивам в TEngineBatch, где цикл по партиям векторизуется
+        static uint64_t Step(uint64_t &s0, uint64_t &s1, uint64_t &s2, uint64_t &s3);
+        void GetState(uint64_t &s0, uint64_t &s1, uint64_t &s2, uint64_t &s3) const;
+
+    private:
+        uint64_t seed;
+        uint64_t s[4];
+
+        static uint64_t Rotl(uint64_t x, int k);
+};
+
+inline TRandom::TRandom(uint64_t seed_arg)
+        : seed(seed_arg) {
+    uint64_t z = seed;
+    for (auto &word : s) {
+        z += 0x9E3779B97F4A7C15ULL;
+        uint64_t x = z;
+        x = (x ^ (x >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        x = (x ^ (x >> 27)) * 0x94D049BB133111EBULL;
+        word = x ^ (x >> 31);
+    }
+}
+
+inline uint64_t TRandom::Rotl(uint64_t x, int k) {
+    return (x << k) | (x >> (64 - k));
+}
+
+inline uint64_t TRandom::Step(uint64_t &s0, uint64_t &s1, uint64_t &s2, uint64_t &s3) {
+    const uint64_t result = Rotl(s1 * 5, 7) * 9;
+    const uint64_t t = s1 << 17;
+
+    s2 ^= s0;
+    s3 ^= s1;
+    s1 ^= s2;
+    s0 ^= s3;
+
+    s2 ^= t;
+    s3 = Rotl(s3, 45);
+
+    return result;
+}
+
+inline uint64_t TRandom::Next() {
+    return Step(s[0], s[1], s[2], s[3]);
+}
+
+inline void TRandom::GetState(uint64_t &s0, uint64_t &s1, uint64_t &s2, uint64_t &s3) const {
+    s0 = s[0];
+    s1 = s[1];
+    s2 = s[2];
+    s3 = s[3];
+}
+
+inline void TRandom::Fill(uint64_t *words, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        words[i] = Next();
+    }
+}
+
+inline uint32_t TRandom::Below(uint32_t limit) {
+    // умножение вместо деления (метод Лемира), смещение не больше 2^-32
+    return static_cast<uint32_t>(((Next() >> 32) * limit) >> 32);
+}
+
+inline uint64_t TRandom::GetSeed() const {
+    return seed;
+}
+
+inline uint64_t TRandom::MakeSeed() {
+    std::random_device device;
+    const uint64_t time = std::chrono::high_resolution_clock::now().time_since_epoch().count();
+    return (uint64_t(device()) << 32) ^ device() ^ time;
+}
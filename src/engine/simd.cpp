@@ -0,0 +1,228 @@
+#include <cstdint>
+#include <cstring>
+#include <stdexcept>
+
+#include "simd.h"
+
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define ENGINE_SIMD_X86
+#include <immintrin.h>
+#define ENGINE_AVX2 __attribute__((target("avx2")))
+#endif
+
+using namespace std;
+
+
+static_assert(sizeof(TBoard) == sizeof(uint64_t), "boards are loaded as packed 64-bit words");
+
+void MoveBoardsScalar(const TBoard *boards, const ETurnDirection *turns, TBoard *result, TMoveSummary *summaries, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        summaries[i] = TMoveSummary();
+        result[i] = TEngine::MoveBoard(boards[i], turns[i], summaries[i]);
+    }
+}
+
+#ifdef ENGINE_SIMD_X86
+
+// любой ход - это ход влево на транспонированном и (или) отражённом поле
+// повороты делаются над четырьмя полями сразу, по полю в 64-битной половине регистра
+
+ENGINE_AVX2 static __m256i Transpose4(__m256i x) {
+    // то же, что TBasicBoard<4, 4>::Transpose
+    const __m256i a = _mm256_or_si256(_mm256_and_si256(x, _mm256_set1_epi64x(0xF0F00F0FF0F00F0FULL)),
+                      _mm256_or_si256(_mm256_slli_epi64(_mm256_and_si256(x, _mm256_set1_epi64x(0x0000F0F00000F0F0ULL)), 12),
+                                      _mm256_srli_epi64(_mm256_and_si256(x, _mm256_set1_epi64x(0x0F0F00000F0F0000ULL)), 12)));
+    return _mm256_or_si256(_mm256_and_si256(a, _mm256_set1_epi64x(0xFF00FF0000FF00FFULL)),
+           _mm256_or_si256(_mm256_srli_epi64(_mm256_and_si256(a, _mm256_set1_epi64x(0x00FF00FF00000000ULL)), 24),
+                           _mm256_slli_epi64(_mm256_and_si256(a, _mm256_set1_epi64x(0x00000000FF00FF00ULL)), 24)));
+}
+
+ENGINE_AVX2 static __m256i MirrorRows4(__m256i x) {
+    // клетки каждой строки в обратном порядке: тетрады в байтах, затем байты в строке
+    const __m256i low_nibbles = _mm256_set1_epi8(0xF);
+    const __m256i swap_bytes = _mm256_setr_epi8(1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14,
+                                                1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14);
+    x = _mm256_or_si256(_mm256_slli_epi16(_mm256_and_si256(x, low_nibbles), 4), _mm256_and_si256(_mm256_srli_epi16(x, 4), low_nibbles));
+    return _mm256_shuffle_epi8(x, swap_bytes);
+}
+
+ENGINE_AVX2 static void GetTurnMasks(const ETurnDirection *turns, __m256i &vertical, __m256i &reverse) {
+    // маски направлений для четырёх полей; направления у соседних полей разные, поэтому без ветвлений
+    static_assert(sizeof(ETurnDirection) == sizeof(int32_t), "turns are loaded as 32-bit integers");
+
+    const __m256i t = _mm256_cvtepi32_epi64(_mm_loadu_si128(reinterpret_cast<const __m128i *>(turns)));
+    const __m256i down = _mm256_cmpeq_epi64(t, _mm256_set1_epi64x(static_cast<int>(ETurnDirection::DOWN)));
+
+    vertical = _mm256_or_si256(_mm256_cmpeq_epi64(t, _mm256_set1_epi64x(static_cast<int>(ETurnDirection::UP))), down);
+    reverse = _mm256_or_si256(_mm256_cmpeq_epi64(t, _mm256_set1_epi64x(static_cast<int>(ETurnDirection::RIGHT))), down);
+}
+
+ENGINE_AVX2 static __m256i ToLeft(__m256i x, __m256i vertical, __m256i reverse) {
+    x = _mm256_blendv_epi8(x, Transpose4(x), vertical);
+    return _mm256_blendv_epi8(x, MirrorRows4(x), reverse);
+}
+
+ENGINE_AVX2 static __m256i FromLeft(__m256i x, __m256i vertical, __m256i reverse) {
+    x = _mm256_blendv_epi8(x, MirrorRows4(x), reverse);
+    return _mm256_blendv_epi8(x, Transpose4(x), vertical);
+}
+
+ENGINE_AVX2 static __m256i CanMerge(__m256i a, __m256i b) {
+    // 0xFF там, где клетка a объединяется со следующей b: равны, не пусты и меньше 0xF
+    const __m256i blocked = _mm256_or_si256(_mm256_cmpeq_epi8(a, _mm256_setzero_si256()), _mm256_cmpeq_epi8(a, _mm256_set1_epi8(0xF)));
+    return _mm256_andnot_si256(blocked, _mm256_cmpeq_epi8(a, b));
+}
+
+ENGINE_AVX2 static __m256i SumBytesPerBoard(__m256i x) {
+    // сумма четырёх байтов (строк одного поля) в каждом 32-битном слове
+    const __m256i pairs = _mm256_maddubs_epi16(x, _mm256_set1_epi8(1));
+    return _mm256_madd_epi16(pairs, _mm256_set1_epi16(1));
+}
+
+ENGINE_AVX2 static void MoveLeft8(__m256i &first, __m256i &second, uint32_t *scores, uint32_t *merges, uint32_t *max_tiles) {
+    // first и second - по четыре поля, после хода в них результат
+    // 8 полей: c[k] - клетки столбца k всех 32 строк, по байту на строку
+    // строки полей в байтах идут группами по 4 в порядке полей 0, 1, 4, 5, 2, 3, 6, 7
+    const __m256i low_nibbles = _mm256_set1_epi8(0xF);
+    const __m256i split = _mm256_setr_epi8(0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15,
+                                           0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15);
+    const __m256i join = _mm256_setr_epi8(0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15,
+                                          0, 8, 1, 9, 2, 10, 3, 11, 4, 12, 5, 13, 6, 14, 7, 15);
+
+    // чётный байт строки - клетки 0 и 1, нечётный - 2 и 3
+    const __m256i a = _mm256_shuffle_epi8(first, split);
+    const __m256i b = _mm256_shuffle_epi8(second, split);
+    const __m256i a_low = _mm256_and_si256(a, low_nibbles), a_high = _mm256_and_si256(_mm256_srli_epi16(a, 4), low_nibbles);
+    const __m256i b_low = _mm256_and_si256(b, low_nibbles), b_high = _mm256_and_si256(_mm256_srli_epi16(b, 4), low_nibbles);
+
+    __m256i c0 = _mm256_unpacklo_epi64(a_low, b_low);
+    __m256i c1 = _mm256_unpacklo_epi64(a_high, b_high);
+    __m256i c2 = _mm256_unpackhi_epi64(a_low, b_low);
+    __m256i c3 = _mm256_unpackhi_epi64(a_high, b_high);
+
+    // сжатие справа налево: пустая клетка забирает уже сжатый хвост строки
+    const __m256i zero = _mm256_setzero_si256();
+    __m256i z = _mm256_cmpeq_epi8(c2, zero);
+    c2 = _mm256_blendv_epi8(c2, c3, z);
+    c3 = _mm256_andnot_si256(z, c3);
+
+    z = _mm256_cmpeq_epi8(c1, zero);
+    c1 = _mm256_blendv_epi8(c1, c2, z);
+    c2 = _mm256_blendv_epi8(c2, c3, z);
+    c3 = _mm256_andnot_si256(z, c3);
+
+    z = _mm256_cmpeq_epi8(c0, zero);
+    c0 = _mm256_blendv_epi8(c0, c1, z);
+    c1 = _mm256_blendv_epi8(c1, c2, z);
+    c2 = _mm256_blendv_epi8(c2, c3, z);
+    c3 = _mm256_andnot_si256(z, c3);
+
+    // объединения слева направо, как в таблице: тайл объединяется не больше одного раза
+    // маска - это -1 в байте, поэтому вычитание маски прибавляет единицу к показателю
+    const __m256i m0 = CanMerge(c0, c1);
+    c0 = _mm256_sub_epi8(c0, m0);
+    c1 = _mm256_blendv_epi8(c1, c2, m0);
+    c2 = _mm256_blendv_epi8(c2, c3, m0);
+    c3 = _mm256_andnot_si256(m0, c3);
+
+    const __m256i m1 = CanMerge(c1, c2);
+    c1 = _mm256_sub_epi8(c1, m1);
+    c2 = _mm256_blendv_epi8(c2, c3, m1);
+    c3 = _mm256_andnot_si256(m1, c3);
+
+    const __m256i m2 = CanMerge(c2, c3);
+    c2 = _mm256_sub_epi8(c2, m2);
+    c3 = _mm256_andnot_si256(m2, c3);
+
+    // сборка обратно в упакованные поля
+    const __m256i a_out = _mm256_or_si256(_mm256_unpacklo_epi64(c0, c2), _mm256_slli_epi16(_mm256_unpacklo_epi64(c1, c3), 4));
+    const __m256i b_out = _mm256_or_si256(_mm256_unpackhi_epi64(c0, c2), _mm256_slli_epi16(_mm256_unpackhi_epi64(c1, c3), 4));
+    first = _mm256_shuffle_epi8(a_out, join);
+    second = _mm256_shuffle_epi8(b_out, join);
+
+    // получившиеся при объединении тайлы; тайл с показателем n стоит 2^(n - 1), младший и старший байты отдельно
+    const __m256i v0 = _mm256_and_si256(m0, c0), v1 = _mm256_and_si256(m1, c1), v2 = _mm256_and_si256(m2, c2);
+    const __m256i value_low = _mm256_setr_epi8(0, 1, 2, 4, 8, 16, 32, 64, char(128), 0, 0, 0, 0, 0, 0, 0,
+                                               0, 1, 2, 4, 8, 16, 32, 64, char(128), 0, 0, 0, 0, 0, 0, 0);
+    const __m256i value_high = _mm256_setr_epi8(0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16, 32, 64,
+                                                0, 0, 0, 0, 0, 0, 0, 0, 0, 1, 2, 4, 8, 16, 32, 64);
+
+    // в строке не больше двух объединений, поэтому суммы пар строк помещаются в 16 бит
+    const __m256i ones = _mm256_set1_epi8(1);
+    const __m256i low = _mm256_add_epi16(_mm256_add_epi16(
+                            _mm256_maddubs_epi16(_mm256_shuffle_epi8(value_low, v0), ones),
+                            _mm256_maddubs_epi16(_mm256_shuffle_epi8(value_low, v1), ones)),
+                            _mm256_maddubs_epi16(_mm256_shuffle_epi8(value_low, v2), ones));
+    const __m256i high = _mm256_add_epi16(_mm256_add_epi16(
+                            _mm256_maddubs_epi16(_mm256_shuffle_epi8(value_high, v0), ones),
+                            _mm256_maddubs_epi16(_mm256_shuffle_epi8(value_high, v1), ones)),
+                            _mm256_maddubs_epi16(_mm256_shuffle_epi8(value_high, v2), ones));
+    const __m256i words = _mm256_set1_epi16(1);
+    const __m256i score = _mm256_add_epi32(_mm256_madd_epi16(low, words), _mm256_slli_epi32(_mm256_madd_epi16(high, words), 8));
+
+    const __m256i merge_count = SumBytesPerBoard(_mm256_sub_epi8(_mm256_sub_epi8(_mm256_sub_epi8(zero, m0), m1), m2));
+
+    __m256i max_tile = _mm256_max_epu8(_mm256_max_epu8(v0, v1), v2);
+    max_tile = _mm256_max_epu8(max_tile, _mm256_srli_epi32(max_tile, 8));
+    max_tile = _mm256_max_epu8(max_tile, _mm256_srli_epi32(max_tile, 16));
+    max_tile = _mm256_and_si256(max_tile, _mm256_set1_epi32(0xFF));
+
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(scores), score);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(merges), merge_count);
+    _mm256_storeu_si256(reinterpret_cast<__m256i *>(max_tiles), max_tile);
+}
+
+bool HasAvx2Moves() {
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+}
+
+ENGINE_AVX2 void MoveBoardsAvx2(const TBoard *boards, const ETurnDirection *turns, TBoard *result, TMoveSummary *summaries, size_t count) {
+    // номер поля для каждого 32-битного слова результатов MoveLeft8
+    const int order[8] = {0, 1, 4, 5, 2, 3, 6, 7};
+
+    size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        uint32_t scores[8], merges[8], max_tiles[8];
+        __m256i vertical_first, reverse_first, vertical_second, reverse_second;
+
+        GetTurnMasks(turns + i, vertical_first, reverse_first);
+        GetTurnMasks(turns + i + 4, vertical_second, reverse_second);
+
+        __m256i first = ToLeft(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(boards + i)), vertical_first, reverse_first);
+        __m256i second = ToLeft(_mm256_loadu_si256(reinterpret_cast<const __m256i *>(boards + i + 4)), vertical_second, reverse_second);
+
+        MoveLeft8(first, second, scores, merges, max_tiles);
+
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i), FromLeft(first, vertical_first, reverse_first));
+        _mm256_storeu_si256(reinterpret_cast<__m256i *>(result + i + 4), FromLeft(second, vertical_second, reverse_second));
+
+        for (int j = 0; j < 8; j++) {
+            TMoveSummary &summary = summaries[i + order[j]];
+            summary.merges = merges[j];
+            summary.score = scores[j];
+            summary.max_tile = static_cast<EEngineTileType>(max_tiles[j]);
+        }
+    }
+
+    MoveBoardsScalar(boards + i, turns + i, result + i, summaries + i, count - i);
+}
+
+#else
+
+bool HasAvx2Moves() {
+    return false;
+}
+
+void MoveBoardsAvx2(const TBoard *, const ETurnDirection *, TBoard *, TMoveSummary *, size_t) {
+    throw runtime_error("AVX2 moves are not available in this build");
+}
+
+#endif
+
+void MoveBoards(const TBoard *boards, const ETurnDirection *turns, TBoard *result, TMoveSummary *summaries, size_t count) {
+    typedef void (*TMoveBoardsFunction)(const TBoard *, const ETurnDirection *, TBoard *, TMoveSummary *, size_t);
+    static const TMoveBoardsFunction implementation = HasAvx2Moves() ? MoveBoardsAvx2 : MoveBoardsScalar;
+
+    implementation(boards, turns, result, summaries, count);
+}
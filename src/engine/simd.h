@@ -0,0 +1,16 @@
+#pragma once
+
+#include <cstddef>
+
+#include <engine/engine.h>
+
+// ход сразу для многих полей 4x4: векторная реализация на AVX2 (8 полей за проход) и обычная
+// MoveBoards при первом вызове выбирает лучшую по CPUID, результаты обеих совпадают до бита
+
+// turns[i] - направление хода для поля i, summaries[i] заполняется заново, а не дополняется
+void MoveBoards(const TBoard *boards, const ETurnDirection *turns, TBoard *result, TMoveSummary *summaries, size_t count);
+
+void MoveBoardsScalar(const TBoard *boards, const ETurnDirection *turns, TBoard *result, TMoveSummary *summaries, size_t count);
+
+bool HasAvx2Moves(); // есть ли AVX2 у процессора и в сборке
+void MoveBoardsAvx2(const TBoard *boards, const ETurnDirection *turns, TBoard *result, TMoveSummary *summaries, size_t count); // только если HasAvx2Moves()
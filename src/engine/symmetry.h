@@ -0,0 +1,113 @@
+#pragma once
+
+#include <cstdint>
+#include <utility>
+
+#include <engine/board.h>
+#include <engine/engine.h>
+
+// восемь симметрий поля 4x4 (повороты и отражения): позиции, переходящие друг в друга, играются одинаково,
+// поэтому в таблицах и наборах данных достаточно хранить одну из них - каноническую, с наименьшим GetRaw
+// преобразование - три бита, применяемые по порядку: транспонирование, отражение строк, отражение столбцов
+
+enum class EBoardSymmetry : uint8_t {
+    IDENTITY = 0,
+    MIRROR_ROWS = 1, // клетка (x, y) переходит в (x, 3 - y), ход влево становится ходом вправо
+    MIRROR_COLUMNS = 2, // (x, y) в (3 - x, y)
+    ROTATE_180 = 3,
+    TRANSPOSE = 4, // (x, y) в (y, x)
+    ROTATE_90 = 5, // по часовой стрелке: (x, y) в (y, 3 - x)
+    ROTATE_270 = 6, // (x, y) в (3 - y, x)
+    ANTI_TRANSPOSE = 7 // (x, y) в (3 - y, 3 - x)
+};
+
+enum ESymmetrySettings {
+    SYMMETRY_COUNT = 8,
+    SYMMETRY_MIRROR_ROWS_BIT = 1,
+    SYMMETRY_MIRROR_COLUMNS_BIT = 2,
+    SYMMETRY_TRANSPOSE_BIT = 4
+};
+
+inline uint64_t MirrorRows(uint64_t x) {
+    // клетки каждой строки в обратном порядке: тетрады в байтах, затем байты в строке
+    x = ((x & 0x0F0F0F0F0F0F0F0FULL) << 4) | ((x >> 4) & 0x0F0F0F0F0F0F0F0FULL);
+    return ((x & 0x00FF00FF00FF00FFULL) << 8) | ((x >> 8) & 0x00FF00FF00FF00FFULL);
+}
+
+inline uint64_t MirrorColumns(uint64_t x) {
+    // строки в обратном порядке
+    x = (x >> 32) | (x << 32);
+    return ((x & 0x0000FFFF0000FFFFULL) << 16) | ((x >> 16) & 0x0000FFFF0000FFFFULL);
+}
+
+inline TBoard ApplySymmetry(const TBoard &board, EBoardSymmetry symmetry) {
+    const int bits = static_cast<int>(symmetry);
+
+    uint64_t x = bits & SYMMETRY_TRANSPOSE_BIT ? board.Transpose().GetRaw() : board.GetRaw();
+    if (bits & SYMMETRY_MIRROR_ROWS_BIT) {
+        x = MirrorRows(x);
+    }
+    if (bits & SYMMETRY_MIRROR_COLUMNS_BIT) {
+        x = MirrorColumns(x);
+    }
+    return TBoard(x);
+}
+
+inline EBoardSymmetry InverseSymmetry(EBoardSymmetry symmetry) {
+    // без транспонирования отражения обратны сами себе; с ним отражения меняются ролями
+    const int bits = static_cast<int>(symmetry);
+    if (!(bits & SYMMETRY_TRANSPOSE_BIT)) {
+        return symmetry;
+    }
+    return static_cast<EBoardSymmetry>(SYMMETRY_TRANSPOSE_BIT
+                                     | (bits & SYMMETRY_MIRROR_ROWS_BIT ? SYMMETRY_MIRROR_COLUMNS_BIT : 0)
+                                     | (bits & SYMMETRY_MIRROR_COLUMNS_BIT ? SYMMETRY_MIRROR_ROWS_BIT : 0));
+}
+
+inline ETurnDirection ApplySymmetry(ETurnDirection turn, EBoardSymmetry symmetry) {
+    // ход на преобразованном поле, соответствующий turn на исходном:
+    // MoveBoard(ApplySymmetry(board, s), ApplySymmetry(turn, s)) == ApplySymmetry(MoveBoard(board, turn), s)
+    const int bits = static_cast<int>(symmetry);
+
+    if (bits & SYMMETRY_TRANSPOSE_BIT) {
+        switch (turn) {
+            case ETurnDirection::UP: turn = ETurnDirection::LEFT; break;
+            case ETurnDirection::LEFT: turn = ETurnDirection::UP; break;
+            case ETurnDirection::DOWN: turn = ETurnDirection::RIGHT; break;
+            case ETurnDirection::RIGHT: turn = ETurnDirection::DOWN; break;
+        }
+    }
+    if (bits & SYMMETRY_MIRROR_ROWS_BIT) {
+        if (turn == ETurnDirection::LEFT || turn == ETurnDirection::RIGHT) {
+            turn = turn == ETurnDirection::LEFT ? ETurnDirection::RIGHT : ETurnDirection::LEFT;
+        }
+    }
+    if (bits & SYMMETRY_MIRROR_COLUMNS_BIT) {
+        if (turn == ETurnDirection::UP || turn == ETurnDirection::DOWN) {
+            turn = turn == ETurnDirection::UP ? ETurnDirection::DOWN : ETurnDirection::UP;
+        }
+    }
+    return turn;
+}
+
+inline std::pair<TBoard, EBoardSymmetry> Canonicalize(const TBoard &board) {
+    // каноническое поле и преобразование, которое переводит в него board:
+    // ApplySymmetry(board, result.second) == result.first
+    // ход, найденный на каноническом поле, переводится обратно через InverseSymmetry(result.second)
+    const uint64_t images[2] = {board.GetRaw(), board.Transpose().GetRaw()};
+
+    uint64_t best = images[0];
+    int best_bits = 0;
+    for (int t = 0; t < 2; t++) {
+        const uint64_t rows = MirrorRows(images[t]);
+        const uint64_t candidates[4] = {images[t], rows, MirrorColumns(images[t]), MirrorColumns(rows)};
+
+        for (int mirror = 0; mirror < 4; mirror++) {
+            if (candidates[mirror] < best) {
+                best = candidates[mirror];
+                best_bits = t * SYMMETRY_TRANSPOSE_BIT | mirror;
+            }
+        }
+    }
+    return std::make_pair(TBoard(best), static_cast<EBoardSymmetry>(best_bits));
+}
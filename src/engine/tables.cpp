@@ -0,0 +1,39 @@
+#include "tables.h"
+
+using namespace std;
+
+
+template <int W>
+static constexpr TRowMoveTableOf<W> MakeRowMoveTable(bool reverse_flag) {
+    TRowMoveTableOf<W> table = {};
+
+    for (size_t row = 0; row < table.size(); row++) {
+        table[row] = MakeRowMove<TRowMove>(row, W, reverse_flag);
+    }
+
+    return table;
+}
+
+template <int W>
+static constexpr TRowLegalTableOf<W> MakeRowLegalTable(const TRowMoveTableOf<W> &left, const TRowMoveTableOf<W> &right) {
+    TRowLegalTableOf<W> table = {};
+
+    for (size_t row = 0; row < table.size(); row++) {
+        table[row] = (left[row].row != row ? ROW_LEGAL_LEFT : 0)
+                   | (right[row].row != row ? ROW_LEGAL_RIGHT : 0);
+    }
+
+    return table;
+}
+
+// таблицы считаются при компиляции и лежат в секции только для чтения:
+// при запуске процесса ничего не строится, а страницы разделяются между процессами
+constexpr TRowMoveTable ROW_MOVES_LEFT = MakeRowMoveTable<4>(false);
+constexpr TRowMoveTable ROW_MOVES_RIGHT = MakeRowMoveTable<4>(true);
+constexpr TRowLegalTable ROW_LEGAL = MakeRowLegalTable<4>(ROW_MOVES_LEFT, ROW_MOVES_RIGHT);
+
+constexpr TRowMoveTableOf<3> ROW_MOVES_LEFT_3 = MakeRowMoveTable<3>(false);
+constexpr TRowMoveTableOf<3> ROW_MOVES_RIGHT_3 = MakeRowMoveTable<3>(true);
+constexpr TRowLegalTableOf<3> ROW_LEGAL_3 = MakeRowLegalTable<3>(ROW_MOVES_LEFT_3, ROW_MOVES_RIGHT_3);
+
+static_assert(ROW_MOVES_LEFT[0x2222].row == 0x0033 && ROW_MOVES_RIGHT[0x2222].row == 0x3300, "row tables must be built at compile time");
@@ -0,0 +1,163 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <array>
+
+// ходы одной упакованной строки: для строк из 3 и 4 клеток - таблицы, для более длинных - счёт на месте
+
+enum ERowTableSettings {
+    ROW_COUNT = 1 << 16
+};
+
+template <typename TRowType, typename TMovesType>
+struct TBasicRowMove {
+    enum {
+        CELLS = 2 * sizeof(TRowType), // сколько клеток помещается в строку
+        MOVE_BITS = 8 * sizeof(TMovesType) / CELLS // бит в moves на клетку
+    };
+
+    // флаги клетки в moves, для 4 бит на клетку совпадают с ERowMoveFlags
+    static constexpr TMovesType POSITION_MASK = (TMovesType(1) << (MOVE_BITS - 2)) - 1;
+    static constexpr TMovesType UNITE = TMovesType(1) << (MOVE_BITS - 2);
+    static constexpr TMovesType NEW_TILE = TMovesType(1) << (MOVE_BITS - 1);
+    static constexpr TMovesType NEW_TILES_MASK = TMovesType(~TMovesType(0)) / ((TMovesType(1) << MOVE_BITS) - 1) * NEW_TILE;
+
+    TRowType row; // строка после хода
+    // для каждой клетки j исходной строки биты MOVE_BITS * j и выше:
+    // младшие - новая позиция тайла, предпоследний - тайл объединился, старший - тайл второй в объединившейся паре
+    TMovesType moves;
+    uint32_t score; // сумма значений получившихся при объединении тайлов
+    uint8_t max_tile; // наибольший тайл, получившийся при объединении, 0 если объединений нет
+};
+
+typedef TBasicRowMove<uint16_t, uint16_t> TRowMove; // до 4 клеток, по 4 бита на клетку в moves
+typedef TBasicRowMove<uint32_t, uint64_t> TWideRowMove; // до 8 клеток, по 8 бит на клетку в moves
+
+enum ERowMoveFlags {
+    ROW_MOVE_POSITION_MASK = 0x3,
+    ROW_MOVE_UNITE = 0x4,
+    ROW_MOVE_NEW_TILE = 0x8,
+    ROW_MOVE_NEW_TILES_MASK = 0x8888 // по одному биту на объединение
+};
+
+enum ERowLegalFlags {
+    ROW_LEGAL_LEFT = 0x1, // сдвиг к клетке 0 меняет строку
+    ROW_LEGAL_RIGHT = 0x2 // сдвиг к последней клетке меняет строку
+};
+
+template <int W>
+using TRowMoveTableOf = std::array<TRowMove, size_t(1) << (4 * W)>;
+template <int W>
+using TRowLegalTableOf = std::array<uint8_t, size_t(1) << (4 * W)>;
+
+typedef TRowMoveTableOf<4> TRowMoveTable;
+typedef TRowLegalTableOf<4> TRowLegalTable;
+
+extern const TRowMoveTable ROW_MOVES_LEFT;  // сдвиг к клетке 0
+extern const TRowMoveTable ROW_MOVES_RIGHT; // сдвиг к клетке 3
+extern const TRowLegalTable ROW_LEGAL; // флаги ERowLegalFlags
+
+extern const TRowMoveTableOf<3> ROW_MOVES_LEFT_3; // то же для строк из 3 клеток
+extern const TRowMoveTableOf<3> ROW_MOVES_RIGHT_3;
+extern const TRowLegalTableOf<3> ROW_LEGAL_3;
+
+template <typename TMove>
+constexpr TMove MakeRowMove(uint32_t row, int line_size, bool reverse_flag) {
+    // ход одной строки из line_size клеток; порядок обхода - от стенки, к которой идёт сдвиг
+    const int max_tile = 0xF; // больше в 4 бита не помещается
+    const int bits = TMove::MOVE_BITS;
+
+    int line[TMove::CELLS] = {}; // итоговые тайлы в порядке обхода
+    int count = 0; // сколько позиций уже занято
+    int previous_column = -1; // клетка последнего тайла, ещё не объединившегося
+
+    TMove result = {0, 0, 0, 0};
+
+    for (int i = 0; i < line_size; i++) {
+        const int column = reverse_flag ? line_size - i - 1 : i;
+        const int val = (row >> (4 * column)) & 0xF;
+
+        if (val == 0) {
+            continue;
+        }
+
+        const int previous = previous_column >= 0 ? (row >> (4 * previous_column)) & 0xF : 0;
+
+        if (val == previous && val < max_tile) { // объединяется с предыдущим
+            const int position = count - 1;
+            const int new_column = reverse_flag ? line_size - position - 1 : position;
+
+            line[position] = val + 1;
+            result.moves |= (new_column | TMove::UNITE) << (bits * previous_column);
+            result.moves |= (new_column | TMove::UNITE | TMove::NEW_TILE) << (bits * column);
+            result.score += 1u << val; // тайл с показателем val + 1 стоит 2^val
+            if (val + 1 > result.max_tile) {
+                result.max_tile = val + 1;
+            }
+
+            previous_column = -1;
+        } else {
+            const int position = count++;
+            const int new_column = reverse_flag ? line_size - position - 1 : position;
+
+            line[position] = val;
+            result.moves |= decltype(result.moves)(new_column) << (bits * column);
+
+            previous_column = column;
+        }
+    }
+
+    for (int i = 0; i < count; i++) {
+        const int column = reverse_flag ? line_size - i - 1 : i;
+        result.row |= uint32_t(line[i]) << (4 * column);
+    }
+
+    return result;
+}
+
+template <int W, bool TABLE = (W == 3 || W == 4)>
+struct TRowKernel {
+    // строки длиннее 4 клеток: таблица заняла бы десятки мегабайт, ход считается на месте
+    typedef TWideRowMove TMove;
+
+    static TMove Move(uint32_t row, bool reverse_flag) {
+        return MakeRowMove<TMove>(row, W, reverse_flag);
+    }
+
+    static int Legal(uint32_t row) {
+        // влево можно, если за пустой клеткой есть тайл, вправо - наоборот; одинаковые соседи - в обе стороны
+        int result = 0;
+        for (int i = 0; i + 1 < W; i++) {
+            const int a = (row >> (4 * i)) & 0xF;
+            const int b = (row >> (4 * i + 4)) & 0xF;
+
+            result |= (a == 0 && b != 0) ? ROW_LEGAL_LEFT : 0;
+            result |= (a != 0 && b == 0) ? ROW_LEGAL_RIGHT : 0;
+            result |= (a != 0 && a == b && a < 0xF) ? ROW_LEGAL_LEFT | ROW_LEGAL_RIGHT : 0;
+        }
+        return result;
+    }
+};
+
+template <int W>
+struct TRowKernel<W, true> {
+    // строки из 3 и 4 клеток: одно обращение к таблице
+    typedef TRowMove TMove;
+
+    static const TMove &Move(uint32_t row, bool reverse_flag) {
+        if constexpr (W == 4) {
+            return reverse_flag ? ROW_MOVES_RIGHT[row] : ROW_MOVES_LEFT[row];
+        } else {
+            return reverse_flag ? ROW_MOVES_RIGHT_3[row] : ROW_MOVES_LEFT_3[row];
+        }
+    }
+
+    static int Legal(uint32_t row) {
+        if constexpr (W == 4) {
+            return ROW_LEGAL[row];
+        } else {
+            return ROW_LEGAL_3[row];
+        }
+    }
+};
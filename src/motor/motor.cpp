@@ -1,7 +1,10 @@
 #include <stdexcept>
+#include <algorithm>
 #include <cmath>
 #include <optional>
+#include <thread>
 
+#include <ai/background_hint.h>
 #include <display/display.h>
 #include <display/view.h>
 #include <engine/engine.h>
@@ -9,35 +12,70 @@
 
 using namespace std;
 
+// подсказка считается в фоне, пока игрок думает, поэтому бюджет намного больше, чем у подсказки по запросу
+static THintSettings BackgroundHintSettings() {
+    THintSettings settings;
+    settings.budget = chrono::seconds(2);
+    return settings;
+}
+
 void TMotor::Run() {
     TDisplay display;
-    TEngine engine;
+    TEngineWithHistory engine;
     TView view(&display);
     
+    // один поток остаётся отрисовке
+    TBackgroundHint hint(max(1, static_cast<int>(thread::hardware_concurrency()) - 1));
+    const THintSettings hint_settings = BackgroundHintSettings();
+    
     while (!display.Closed()) {
         display.ProcessEvents();
         
+        // новая позиция (ход, отмена, повтор) прерывает перебор старой; повторный запрос той же позиции бесплатен
         if (!engine.IsEnd()) {
-            auto turn = view.GetTurn();
-            
-            if (turn) {
-                auto shifts = engine.MakeTurn(*turn);
-                if (shifts) {
-                    engine.AfterTurn();
-                    view.Animate((*shifts).first, (*shifts).second, engine);
-                    
-                    
-                    /*int x = random_tile.first;
-                    int y = random_tile.second;
-                    view.AnimateRandomTile(x, y, engine);*/
-                }
+            hint.Request(engine.GetBoard(), hint_settings);
+        } else {
+            hint.Cancel();
+        }
+        
+        auto key = view.GetKey();
+        
+        optional<ETurnDirection> turn;
+        if (key && TView::IsDirection(*key)) {
+            turn = TView::KeyToDirection(*key);
+        } else if (key == EKey::KEY_HINT) {
+            // самая глубокая досчитанная глубина, до первой - оценка поля; отрисовка перебора не ждёт
+            const THint now = hint.GetHintNow(engine.GetBoard());
+            if (now.found_flag) {
+                turn = now.best_move;
             }
+        }
+        
+        // отмена и повтор работают и после конца игры
+        if (key == EKey::KEY_UNDO) {
+            engine.Undo();
+        } else if (key == EKey::KEY_REDO) {
+            engine.Redo();
+        } else if (turn && !engine.IsEnd()) {
+            auto turn_result = engine.MakeTurn(*turn);
             
+            if (turn_result) {
+                engine.AfterTurn();
+                view.Animate(*turn_result, engine);
+                
+                
+                /*int x = random_tile.first;
+                int y = random_tile.second;
+                view.AnimateRandomTile(x, y, engine);*/
+            }
+        }
+        
+        if (!engine.IsEnd()) {
             view.Render(engine);
+        } else if (engine.IsLose()) { // в режиме продолжения проигрыш возможен и после выигрыша
+            view.LoseScreen(engine);
         } else if (engine.IsWin()) {
             view.WinScreen(engine);
-        } else if (engine.IsLose()) {
-            view.LoseScreen(engine);
         } else {
             throw runtime_error("Inconsistent IsEnd, IsWin, IsLose result");
         }
@@ -0,0 +1,141 @@
+#include <chrono>
+#include <iostream>
+#include <memory>
+#include <iomanip>
+#include <string>
+#include <stdexcept>
+#include <thread>
+
+#include <ai/hint_service.h>
+#include <ai/rollout.h>
+#include <ai/solver.h>
+#include <selfplay/selfplay.h>
+
+// 2048_selfplay - партии без окна: нагрузка и базовая скорость движка
+// 2048_selfplay [--games M] [--threads K] [--policy random|greedy|...] [--seed S] [--stop-at-win]
+
+using namespace std;
+
+static TThreadPool &GetAiPool() {
+    // один пул на все потоки партий: ИИ сам распараллеливает ход
+    static TThreadPool pool;
+    return pool;
+}
+
+static void RegisterAiPolicies() {
+    RegisterPolicy("montecarlo", []() {
+        auto rollout = make_shared<TRollout>(GetAiPool());
+        return TPolicy([rollout](const TEngine &engine, TRandom &random) {
+            TRolloutSettings settings;
+            settings.rollouts_per_move = 100;
+            settings.seed = random.Next();
+            return rollout->Evaluate(engine, settings, TRollout::TClock::now() + chrono::milliseconds(20)).best_move;
+        });
+    });
+
+    RegisterPolicy("expectimax", []() {
+        auto solver = make_shared<TSolver>();
+        return TPolicy([solver](const TEngine &engine, TRandom &) {
+            return solver->BestMove(engine, TSolverBudget()).best_move;
+        });
+    });
+
+    RegisterPolicy("hint", []() {
+        // итеративное углубление в пределах 20 мс на ход; сервис на поток партий, пул и таблица общие
+        static TTranspositionTable table;
+        auto service = make_shared<THintService>(GetAiPool(), table);
+        return TPolicy([service](const TEngine &engine, TRandom &) {
+            return service->GetHint(engine, THintSettings()).best_move;
+        });
+    });
+}
+
+static void PrintUsage() {
+    cerr << "usage: 2048_selfplay [--games M] [--threads K] [--policy NAME] [--seed S] [--stop-at-win]" << endl;
+    cerr << "policies:";
+    for (const string &name : GetPolicyNames()) {
+        cerr << " " << name;
+    }
+    cerr << endl;
+}
+
+static TSelfPlaySettings ParseArguments(int argc, char **argv, string &policy) {
+    TSelfPlaySettings settings;
+    settings.threads = max(1u, thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++) {
+        const string arg = argv[i];
+
+        if (arg == "--stop-at-win") {
+            settings.keep_playing_flag = false;
+            continue;
+        }
+        if (i + 1 >= argc) {
+            throw runtime_error("Missing value for " + arg);
+        }
+
+        const string value = argv[++i];
+        if (arg == "--games") {
+            settings.games = stoi(value);
+        } else if (arg == "--threads") {
+            settings.threads = stoi(value);
+        } else if (arg == "--policy") {
+            policy = value;
+        } else if (arg == "--seed") {
+            settings.seed = stoull(value);
+        } else {
+            throw runtime_error("Unknown argument " + arg);
+        }
+    }
+
+    // те же проверки делает TSelfPlay::Run, но здесь ошибка попадает в вывод с подсказкой
+    if (settings.games < 0) {
+        throw runtime_error("--games must not be negative");
+    }
+    if (settings.threads < 1) {
+        throw runtime_error("--threads must be at least 1");
+    }
+    return settings;
+}
+
+int main(int argc, char **argv) {
+    string policy = "random";
+    TSelfPlaySettings settings;
+    TPolicyFactory factory;
+
+    RegisterAiPolicies();
+
+    try {
+        settings = ParseArguments(argc, argv, policy);
+        factory = GetPolicyFactory(policy);
+    } catch (const exception &e) {
+        cerr << e.what() << endl;
+        PrintUsage();
+        return 1;
+    }
+
+    const TSelfPlayReport report = TSelfPlay::Run(settings, factory);
+
+    cout << fixed << setprecision(1);
+    cout << "policy " << policy << ", " << report.games.size() << " games on " << settings.threads << " threads, seed " << settings.seed << endl;
+    cout << "time       " << setprecision(3) << report.seconds << " s" << setprecision(1) << endl;
+    cout << "games/s    " << report.GetGamesPerSecond() << endl;
+    cout << "moves/s    " << report.GetMovesPerSecond() << endl;
+    cout << "moves      " << report.GetTotalMoves() << endl;
+
+    cout << "score      p50 " << report.GetScorePercentile(0.5)
+         << "  p90 " << report.GetScorePercentile(0.9)
+         << "  p99 " << report.GetScorePercentile(0.99)
+         << "  max " << report.GetScorePercentile(1) << endl;
+
+    cout << "max tile" << endl;
+    const vector<int> counts = report.GetMaxTileCounts();
+    for (size_t i = 1; i < counts.size(); i++) {
+        if (counts[i] > 0) {
+            cout << "  " << setw(6) << (1 << (i - 1)) << "  " << setw(8) << counts[i]
+                 << "  " << setw(5) << 100.0 * counts[i] / report.games.size() << "%" << endl;
+        }
+    }
+
+    return 0;
+}
@@ -0,0 +1,81 @@
+#include <map>
+#include <stdexcept>
+
+#include "policy.h"
+
+using namespace std;
+
+static const ETurnDirection ALL_TURNS[] = {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT};
+
+static map<string, TPolicyFactory> &GetRegistry() {
+    static map<string, TPolicyFactory> registry = {
+        {"random", MakeRandomPolicy},
+        {"greedy", MakeGreedyPolicy}
+    };
+    return registry;
+}
+
+TPolicy MakeRandomPolicy() {
+    return [](const TEngine &engine, TRandom &random) {
+        const int legal = engine.LegalMoves();
+        int k = random.Below(PopCount(legal));
+
+        for (ETurnDirection turn : ALL_TURNS) {
+            if (legal & (1 << static_cast<int>(turn))) {
+                if (k-- == 0) {
+                    return turn;
+                }
+            }
+        }
+        throw runtime_error("No legal moves for the policy");
+    };
+}
+
+TPolicy MakeGreedyPolicy() {
+    return [](const TEngine &engine, TRandom &) {
+        const int legal = engine.LegalMoves();
+
+        bool found_flag = false;
+        ETurnDirection best_turn = ETurnDirection::UP;
+        pair<uint32_t, int> best_value;
+
+        for (ETurnDirection turn : ALL_TURNS) {
+            if (legal & (1 << static_cast<int>(turn))) {
+                TMoveSummary summary;
+                const TBoard moved = TEngine::MoveBoard(engine.GetBoard(), turn, summary);
+                const pair<uint32_t, int> value(summary.score, moved.CountEmpty());
+
+                if (!found_flag || value > best_value) {
+                    found_flag = true;
+                    best_turn = turn;
+                    best_value = value;
+                }
+            }
+        }
+
+        if (!found_flag) {
+            throw runtime_error("No legal moves for the policy");
+        }
+        return best_turn;
+    };
+}
+
+void RegisterPolicy(const string &name, const TPolicyFactory &factory) {
+    GetRegistry()[name] = factory;
+}
+
+TPolicyFactory GetPolicyFactory(const string &name) {
+    const auto it = GetRegistry().find(name);
+    if (it == GetRegistry().end()) {
+        throw runtime_error("Unknown policy " + name);
+    }
+    return it->second;
+}
+
+vector<string> GetPolicyNames() {
+    vector<string> result;
+    for (const auto &item : GetRegistry()) {
+        result.push_back(item.first);
+    }
+    return result;
+}
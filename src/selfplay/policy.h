@@ -0,0 +1,23 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <functional>
+
+#include <engine/engine.h>
+
+// TPolicy - выбор хода по позиции; вызывается, только если есть хотя бы один ход, меняющий поле
+// random - генератор партии, политика может брать из него числа, партия от этого остаётся повторяемой
+
+typedef std::function<ETurnDirection(const TEngine &engine, TRandom &random)> TPolicy;
+
+// политика создаётся заново для каждого потока, поэтому может хранить своё состояние без блокировок
+typedef std::function<TPolicy()> TPolicyFactory;
+
+TPolicy MakeRandomPolicy(); // равновероятно среди ходов, меняющих поле
+TPolicy MakeGreedyPolicy(); // больше всего очков за ход, при равенстве - больше пустых клеток
+
+// политики по имени для командной строки; сторонние (например, ИИ) добавляются через RegisterPolicy
+void RegisterPolicy(const std::string &name, const TPolicyFactory &factory);
+TPolicyFactory GetPolicyFactory(const std::string &name); // runtime_error для неизвестного имени
+std::vector<std::string> GetPolicyNames();
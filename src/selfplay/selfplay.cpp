@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <stdexcept>
+#include <thread>
+
+#include "selfplay.h"
+
+using namespace std;
+
+double TSelfPlayReport::GetGamesPerSecond() const {
+    return seconds > 0 ? games.size() / seconds : 0;
+}
+
+double TSelfPlayReport::GetMovesPerSecond() const {
+    return seconds > 0 ? GetTotalMoves() / seconds : 0;
+}
+
+uint64_t TSelfPlayReport::GetTotalMoves() const {
+    uint64_t result = 0;
+    for (const TGameResult &game : games) {
+        result += game.move_count;
+    }
+    return result;
+}
+
+vector<int> TSelfPlayReport::GetMaxTileCounts() const {
+    vector<int> result(static_cast<int>(EEngineTileType::TILE_16384) + 1);
+    for (const TGameResult &game : games) {
+        result[static_cast<int>(game.max_tile)]++;
+    }
+    return result;
+}
+
+uint32_t TSelfPlayReport::GetScorePercentile(double p) const {
+    if (games.empty()) {
+        return 0;
+    }
+
+    vector<uint32_t> scores;
+    scores.reserve(games.size());
+    for (const TGameResult &game : games) {
+        scores.push_back(game.score);
+    }
+
+    // ближайший ранг: наименьшее значение, не меньше которого доля p всех партий
+    const double rank_value = ceil(p * scores.size()) - 1;
+    const size_t rank = static_cast<size_t>(max(0.0, min(rank_value, double(scores.size() - 1))));
+    nth_element(scores.begin(), scores.begin() + rank, scores.end());
+    return scores[rank];
+}
+
+TGameResult TSelfPlay::PlayGame(uint64_t seed, bool keep_playing_flag, const TPolicy &policy) {
+    TEngine engine(seed);
+    engine.SetKeepPlaying(keep_playing_flag);
+
+    // у политики свой генератор, чтобы её случайность не сдвигала появление тайлов
+    TRandom random(~seed);
+
+    while (!engine.IsEnd()) {
+        if (!engine.ApplyMove(policy(engine, random))) {
+            throw runtime_error("Policy chose a move that does not change the field");
+        }
+        engine.AfterTurn();
+    }
+
+    TGameResult result;
+    result.score = engine.GetScore();
+    result.move_count = engine.GetMoveCount();
+    result.max_tile = engine.GetBoard().GetMaxTile();
+    return result;
+}
+
+TSelfPlayReport TSelfPlay::Run(const TSelfPlaySettings &settings, const TPolicyFactory &factory) {
+    if (settings.games < 0 || settings.threads < 1) {
+        throw runtime_error("Wrong self-play settings");
+    }
+
+    TSelfPlayReport report;
+    report.games.resize(settings.games);
+
+    // политики создаются до запуска часов: ИИ может долго строить таблицы
+    vector<TPolicy> policies;
+    for (int i = 0; i < settings.threads; i++) {
+        policies.push_back(factory());
+    }
+
+    atomic<int> next_game(0);
+    exception_ptr error;
+    atomic<bool> error_flag(false);
+
+    auto worker = [&](int thread_number) {
+        try {
+            for (int i = next_game++; i < settings.games && !error_flag; i = next_game++) {
+                report.games[i] = PlayGame(settings.seed + i, settings.keep_playing_flag, policies[thread_number]);
+            }
+        } catch (...) {
+            // первая ошибка передаётся вызывающему, остальные потоки доигрывают текущую партию и выходят
+            if (!error_flag.exchange(true)) {
+                error = current_exception();
+            }
+        }
+    };
+
+    const auto start = chrono::steady_clock::now();
+
+    vector<thread> threads;
+    for (int i = 1; i < settings.threads; i++) {
+        threads.emplace_back(worker, i);
+    }
+    worker(0);
+    for (thread &t : threads) {
+        t.join();
+    }
+
+    const chrono::duration<double> elapsed = chrono::steady_clock::now() - start;
+    report.seconds = elapsed.count();
+
+    if (error) {
+        rethrow_exception(error);
+    }
+    return report;
+}
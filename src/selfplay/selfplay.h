@@ -0,0 +1,41 @@
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <engine/engine.h>
+#include <selfplay/policy.h>
+
+// TSelfPlay - партии без окна, на нескольких потоках; партия i играется с seed + i,
+// поэтому результаты не зависят от числа потоков и порядка, в котором потоки берут партии
+
+struct TGameResult {
+    uint32_t score = 0;
+    uint32_t move_count = 0;
+    EEngineTileType max_tile = EEngineTileType::TILE_0;
+};
+
+struct TSelfPlaySettings {
+    int games = 1000;
+    int threads = 1;
+    uint64_t seed = 1;
+    bool keep_playing_flag = true; // играть до проигрыша, а не до первой победы
+};
+
+struct TSelfPlayReport {
+    std::vector<TGameResult> games; // в порядке номеров партий
+    double seconds = 0; // время игры всех партий, без запуска потоков
+
+    double GetGamesPerSecond() const;
+    double GetMovesPerSecond() const;
+    uint64_t GetTotalMoves() const;
+
+    std::vector<int> GetMaxTileCounts() const; // по индексу static_cast<int>(EEngineTileType)
+    uint32_t GetScorePercentile(double p) const; // p из [0, 1], ближайший ранг
+};
+
+class TSelfPlay {
+    public:
+        static TSelfPlayReport Run(const TSelfPlaySettings &settings, const TPolicyFactory &factory);
+        static TGameResult PlayGame(uint64_t seed, bool keep_playing_flag, const TPolicy &policy);
+};
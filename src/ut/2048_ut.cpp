@@ -1,5 +1,15 @@
 #include <vector>
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <thread>
 #include <optional>
+#include <new>
+#include <cstdlib>
+#include <random>
+#include <type_traits>
+#include <unordered_set>
+#include <numeric>
 
 #include <gtest/gtest.h>
 #include <gmock/gmock.h>
@@ -7,7 +17,20 @@
 #include <display/display.h>
 #include <display/view.h>
 #include <engine/engine.h>
+#include <engine/batch.h>
+#include <engine/simd.h>
+#include <engine/symmetry.h>
+#include <engine/tables.h>
+#include <ai/background_hint.h>
+#include <ai/heuristic.h>
+#include <ai/hint_service.h>
+#include <ai/parallel_solver.h>
+#include <ai/rollout.h>
+#include <ai/solver.h>
+#include <ai/thread_pool.h>
+#include <ai/transposition.h>
 #include <motor/motor.h>
+#include <selfplay/selfplay.h>
 
 using namespace std;
 
@@ -32,11 +55,29 @@ auto t512 = EEngineTileType::TILE_512;
 auto t1024 = EEngineTileType::TILE_1024;
 auto t2048 = EEngineTileType::TILE_2048;
 
+size_t allocations_count = 0; // сколько раз вызывался глобальный operator new
+
+void *operator new(size_t size) {
+    allocations_count++;
+    if (void *result = malloc(size ? size : 1)) {
+        return result;
+    }
+    throw bad_alloc();
+}
+
+void operator delete(void *ptr) noexcept {
+    free(ptr);
+}
+
+void operator delete(void *ptr, size_t) noexcept {
+    free(ptr);
+}
+
 bool IsEqual(const TEngine &engine, vector<vector<EEngineTileType>> v) {
     // сравнение двумерного вектора и TEngine
     bool result = true;
-    for (size_t i; i < engine.GetXSize(); i++) {
-        for (size_t j; j < engine.GetXSize(); j++) {
+    for (int i = 0; i < engine.GetXSize(); i++) {
+        for (int j = 0; j < engine.GetYSize(); j++) {
             if (engine(i,j) != v[i][j]) {
                 result = false;
                 break;
@@ -89,6 +130,39 @@ TEST(EngineTest, EmptyField) {
         
 }
 
+TEST(EngineTest, PackedBoard) {
+    static_assert(sizeof(TBoard) == sizeof(uint64_t), "TBoard must fit one machine word");
+    static_assert(std::is_trivially_copyable<TBoard>::value, "TBoard must be trivially copyable");
+    
+    vector<vector<EEngineTileType>> field = 
+                        {   {t2, t0, t0, t2048},
+                            {t0, t4, t0, t0},
+                            {t0, t0, t1024, t0},
+                            {t8, t0, t0, t16}    };
+    
+    TEngine engine(field);
+    const TBoard &board = engine.GetBoard();
+    
+    EXPECT_TRUE(IsEqual(engine, field));
+    for (int i = 0; i < board.GetXSize(); i++) {
+        for (int j = 0; j < board.GetYSize(); j++) {
+            EXPECT_EQ(board(i, j), field[i][j]);
+        }
+    }
+    
+    // клетка (x, y) лежит в битах 16 * x + 4 * y
+    EXPECT_EQ(board.GetRaw() & 0xFFFF, 0xC002u);
+    EXPECT_EQ(board.GetRow(3), 0x5004u);
+    
+    TBoard copy(board.GetRaw());
+    EXPECT_EQ(copy, board);
+    copy.Set(1, 1, t0);
+    EXPECT_NE(copy, board);
+    
+    unordered_set<TBoard> boards = {board, copy, TBoard(board.GetRaw())};
+    EXPECT_EQ(boards.size(), 2u);
+}
+
 TEST(EngineTest, Size) {
     TEngine engine;
     
@@ -166,6 +240,157 @@ TEST(EngineTest, ThreeTilesTurn) {
     
 }
 
+TEST(EngineTest, VerticalTurnShifts) {
+    vector<vector<EEngineTileType>> field = 
+                        {   {t2, t0, t0, t0},
+                            {t2, t0, t0, t4},
+                            {t4, t0, t0, t0},
+                            {t0, t0, t0, t0}    };
+    
+    TEngine engine(field);
+    
+    auto result = engine.MakeTurn(ETurnDirection::DOWN);
+    ASSERT_TRUE(result);
+    
+    vector<vector<EEngineTileType>> result_field = 
+                        {   {t0, t0, t0, t0},
+                            {t0, t0, t0, t0},
+                            {t4, t0, t0, t0},
+                            {t4, t0, t0, t4}    };
+    
+    EXPECT_TRUE(IsEqual(engine, result_field)) << "Vertical move failed";
+    
+    // в сдвигах x - номер столбца, y - номер строки
+    const auto &shifts = (*result).shifts;
+    ASSERT_EQ(shifts.size(), 4u);
+    EXPECT_EQ(make_pair(shifts[0].y_old, shifts[0].y_new), make_pair(2, 3));
+    EXPECT_FALSE(shifts[0].unite_flag);
+    EXPECT_EQ(make_pair(shifts[1].y_old, shifts[1].y_new), make_pair(1, 2));
+    EXPECT_TRUE(shifts[1].unite_flag);
+    EXPECT_EQ(make_pair(shifts[2].y_old, shifts[2].y_new), make_pair(0, 2));
+    EXPECT_TRUE(shifts[2].unite_flag);
+    EXPECT_EQ(make_pair(shifts[3].x_old, shifts[3].y_new), make_pair(3, 3));
+    
+    const auto &new_tiles = (*result).new_tiles;
+    ASSERT_EQ(new_tiles.size(), 1u);
+    EXPECT_EQ(new_tiles[0].x, 0);
+    EXPECT_EQ(new_tiles[0].y, 2);
+    EXPECT_EQ(new_tiles[0].type, t4);
+    EXPECT_EQ(new_tiles[0].cells_to_appear, 2);
+}
+
+TEST(EngineTest, TurnWithoutAllocations) {
+    vector<vector<EEngineTileType>> field = 
+                        {   {t2, t2, t4, t4},
+                            {t8, t0, t8, t0},
+                            {t2, t4, t8, t16},
+                            {t2, t2, t2, t2}    };
+    
+    TEngine engine(field);
+    
+    const size_t allocations_before = allocations_count;
+    auto result = engine.MakeTurn(ETurnDirection::RIGHT);
+    auto result2 = engine.MakeTurn(ETurnDirection::UP);
+    const size_t allocations_after = allocations_count;
+    engine.AfterTurn();
+    const size_t allocations_after_tile = allocations_count;
+    
+    ASSERT_TRUE(result);
+    ASSERT_TRUE(result2);
+    EXPECT_EQ(allocations_after, allocations_before) << "MakeTurn must not allocate";
+    EXPECT_EQ(allocations_after_tile, allocations_after) << "AfterTurn must not allocate";
+    
+    EXPECT_EQ((*result).shifts.size(), 14u);
+    EXPECT_EQ((*result).new_tiles.size(), 5u);
+    EXPECT_EQ((*result).shifts.capacity(), size_t(SIZE_OF_FIELD_X * SIZE_OF_FIELD_Y));
+}
+
+TEST(EngineTest, ApplyMoveMatchesMakeTurn) {
+    mt19937 generator(2048);
+    
+    for (int k = 0; k < 1000; k++) {
+        vector<vector<EEngineTileType>> field(SIZE_OF_FIELD_X, vector<EEngineTileType>(SIZE_OF_FIELD_Y));
+        for (auto &line : field) {
+            for (auto &cell : line) {
+                cell = static_cast<EEngineTileType>(generator() % 6);
+            }
+        }
+        
+        for (auto turn : {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT}) {
+            TEngine full(field), fast(field);
+            
+            if (full.IsEnd()) {
+                continue;
+            }
+            
+            auto result = full.MakeTurn(turn);
+            bool changed = fast.ApplyMove(turn);
+            
+            ASSERT_EQ(bool(result), changed);
+            ASSERT_EQ(full.GetBoard(), fast.GetBoard());
+            
+            if (result) {
+                auto lazy = TEngine::DescribeTurn(TEngine(field).GetBoard(), turn);
+                ASSERT_EQ(lazy.shifts.size(), (*result).shifts.size());
+                ASSERT_EQ(lazy.new_tiles.size(), (*result).new_tiles.size());
+                for (size_t i = 0; i < lazy.shifts.size(); i++) {
+                    EXPECT_EQ(lazy.shifts[i].x_new, (*result).shifts[i].x_new);
+                    EXPECT_EQ(lazy.shifts[i].y_new, (*result).shifts[i].y_new);
+                }
+            }
+        }
+    }
+}
+
+TEST(EngineTest, LegalMovesMask) {
+    vector<vector<EEngineTileType>> field = 
+                        {   {t2, t4, t8, t16},
+                            {t0, t0, t0, t0},
+                            {t0, t0, t0, t0},
+                            {t0, t0, t0, t0}    };
+    
+    TEngine engine(field);
+    EXPECT_EQ(engine.LegalMoves(), 1 << static_cast<int>(ETurnDirection::DOWN));
+    
+    mt19937_64 generator(9);
+    for (int k = 0; k < 100000; k++) {
+        uint64_t cells = 0;
+        for (int i = 0; i < 16; i++) {
+            cells |= uint64_t(generator() % 5) << (4 * i);
+        }
+        
+        TBoard board(cells);
+        int expected = 0;
+        for (auto turn : {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT}) {
+            if (TEngine::MoveBoard(board, turn) != board) {
+                expected |= 1 << static_cast<int>(turn);
+            }
+        }
+        
+        ASSERT_EQ(TEngine::LegalMoves(board), expected) << hex << cells;
+    }
+}
+
+TEST(EngineTest, RowTablesMirror) {
+    // ход вправо - это ход влево по перевёрнутой строке
+    auto reverse_row = [](uint32_t row) {
+        return ((row & 0xF) << 12) | ((row & 0xF0) << 4) | ((row >> 4) & 0xF0) | (row >> 12);
+    };
+    
+    for (uint32_t row = 0; row < ROW_COUNT; row++) {
+        const TRowMove &left = ROW_MOVES_LEFT[row];
+        const TRowMove &right = ROW_MOVES_RIGHT[reverse_row(row)];
+        
+        ASSERT_EQ(reverse_row(left.row), right.row) << "row " << row;
+        ASSERT_EQ(left.score, right.score) << "row " << row;
+    }
+    
+    EXPECT_EQ(ROW_MOVES_LEFT[0x2222].row, 0x0033);
+    EXPECT_EQ(ROW_MOVES_LEFT[0x2222].score, 8u);
+    EXPECT_EQ(ROW_MOVES_RIGHT[0x1203].row, 0x1230);
+    EXPECT_EQ(ROW_MOVES_LEFT[0xFF00].row, 0x00FF) << "Tiles beyond 4 bits must not merge";
+}
+
 TEST(EngineTest, RandomTile) {
     vector<vector<EEngineTileType>> field = 
                         {   {t2, t0, t0, t0},
@@ -206,6 +431,331 @@ TEST(EngineTest, RandomTile) {
     EXPECT_FALSE(double_encounter) << "There are more than one random tiles";
 }
 
+TEST(EngineTest, SpawnFromBitmask) {
+    vector<vector<EEngineTileType>> field = 
+                        {   {t2, t0, t4, t4},
+                            {t8, t8, t8, t8},
+                            {t2, t4, t0, t16},
+                            {t2, t2, t2, t0}    };
+    
+    TBoard board(field);
+    EXPECT_EQ(board.GetEmptyCells(), 0x1000010000000010ULL);
+    
+    // старшие 32 бита выбирают пустую клетку, младшие - 2 или 4
+    TBoard first = board;
+    EXPECT_EQ(TEngine::SpawnTile(first, 0x00000000FFFFFFFFULL, false), 1);
+    EXPECT_EQ(first(0, 1), t2);
+    
+    TBoard last = board;
+    EXPECT_EQ(TEngine::SpawnTile(last, 0xFFFFFFFF00000000ULL, false), 15);
+    EXPECT_EQ(last(3, 3), t4);
+    
+    TBoard middle = board;
+    EXPECT_EQ(TEngine::SpawnTile(middle, 0x8000000000000000ULL, true), 10);
+    EXPECT_EQ(middle(2, 2), t2);
+    
+    TBoard full(~0ULL);
+    EXPECT_EQ(TEngine::SpawnTile(full, 0, false), -1);
+    
+    // заранее вытянутые числа дают ту же партию, что и собственный генератор
+    const uint64_t seed = 42;
+    TRandom random(seed);
+    uint64_t words[64];
+    random.Fill(words, 64);
+    
+    TRandom same(seed);
+    for (auto word : words) {
+        ASSERT_EQ(word, same.Next());
+    }
+    
+    int fours = 0;
+    TRandom spawner(seed);
+    for (int i = 0; i < 10000; i++) {
+        TBoard empty;
+        int cell = TEngine::SpawnTile(empty, spawner.Next(), false);
+        ASSERT_TRUE(cell >= 0 && cell < SIZE_OF_FIELD_X * SIZE_OF_FIELD_Y);
+        fours += empty(cell / SIZE_OF_FIELD_Y, cell % SIZE_OF_FIELD_Y) == t4;
+    }
+    EXPECT_NEAR(fours, 1000, 150);
+}
+
+TEST(EngineTest, SeededGamesRepeat) {
+    const uint64_t seed = 123456789;
+    
+    TEngine engine(seed), replay(seed), other(seed + 1);
+    EXPECT_EQ(engine.GetSeed(), seed);
+    EXPECT_EQ(replay.GetSeed(), seed);
+    
+    const ETurnDirection turns[] = {ETurnDirection::LEFT, ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN};
+    
+    bool diverged = false;
+    for (int i = 0; i < 200 && !engine.IsEnd(); i++) {
+        auto turn = turns[i % 4];
+        
+        bool moved = engine.ApplyMove(turn);
+        ASSERT_EQ(moved, replay.ApplyMove(turn));
+        
+        if (moved) {
+            ASSERT_EQ(engine.AfterTurn(), replay.AfterTurn());
+        }
+        ASSERT_EQ(engine.GetBoard(), replay.GetBoard()) << "Games with the same seed diverged";
+        
+        if (!other.IsEnd() && other.ApplyMove(turn)) {
+            other.AfterTurn();
+        }
+        diverged = diverged || other.GetBoard() != engine.GetBoard();
+    }
+    
+    EXPECT_TRUE(diverged) << "Different seeds gave the same game";
+}
+
+TEST(EngineTest, SnapshotRestore) {
+    static_assert(sizeof(TEngineState) <= 64, "TEngineState must fit a cache line");
+    
+    TEngine engine(42);
+    engine.SetKeepPlaying(true);
+    
+    const size_t allocations_before = allocations_count;
+    const TEngineState snapshot = engine.Snapshot();
+    
+    // после восстановления партия повторяется, в том числе новые тайлы
+    TBoard boards[2];
+    for (int branch = 0; branch < 2; branch++) {
+        engine.Restore(snapshot);
+        for (int i = 0; i < 50 && !engine.IsEnd(); i++) {
+            if (engine.ApplyMove(static_cast<ETurnDirection>(i % 4))) {
+                engine.AfterTurn();
+            }
+        }
+        boards[branch] = engine.GetBoard();
+    }
+    EXPECT_EQ(allocations_count, allocations_before) << "Snapshot and Restore must not allocate";
+    EXPECT_EQ(boards[0], boards[1]);
+    
+    TEngine copy(snapshot);
+    EXPECT_EQ(copy.GetBoard(), snapshot.board);
+    EXPECT_EQ(copy.GetSeed(), engine.GetSeed());
+    EXPECT_TRUE(copy.GetKeepPlaying());
+    
+    engine.Restore(snapshot);
+    EXPECT_EQ(engine.GetBoard(), copy.GetBoard());
+}
+
+TEST(EngineTest, UndoRedo) {
+    TEngineWithHistory engine(7);
+    EXPECT_FALSE(engine.Undo());
+    
+    vector<TBoard> boards = {engine.GetBoard()};
+    for (int i = 0; boards.size() < 6; i++) {
+        if (engine.MakeTurn(static_cast<ETurnDirection>(i % 4))) {
+            engine.AfterTurn();
+            boards.push_back(engine.GetBoard());
+        }
+    }
+    EXPECT_EQ(engine.GetUndoCount(), 5);
+    
+    ASSERT_TRUE(engine.Undo(3));
+    EXPECT_EQ(engine.GetBoard(), boards[2]);
+    EXPECT_EQ(engine.GetRedoCount(), 3);
+    
+    ASSERT_TRUE(engine.Redo(2));
+    EXPECT_EQ(engine.GetBoard(), boards[4]);
+    ASSERT_TRUE(engine.Undo(4));
+    EXPECT_EQ(engine.GetBoard(), boards[0]);
+    EXPECT_FALSE(engine.Undo());
+    ASSERT_TRUE(engine.Redo(5));
+    EXPECT_EQ(engine.GetBoard(), boards[5]);
+    EXPECT_FALSE(engine.Redo());
+    
+    // после отмены партия повторяется вместе с новыми тайлами, а новый ход забывает повтор
+    ASSERT_TRUE(engine.Undo());
+    TEngine replay(engine.Snapshot());
+    for (int i = 0; i < 4; i++) {
+        auto turn = static_cast<ETurnDirection>(i);
+        if (engine.MakeTurn(turn)) {
+            ASSERT_TRUE(replay.MakeTurn(turn));
+            ASSERT_EQ(engine.AfterTurn(), replay.AfterTurn());
+            EXPECT_EQ(engine.GetRedoCount(), 0);
+            break;
+        }
+    }
+    EXPECT_EQ(engine.GetBoard(), replay.GetBoard());
+}
+
+TEST(EngineTest, HistoryRingBuffer) {
+    THistory<int, 4> history;
+    for (int i = 0; i < 10; i++) {
+        history.Push(i);
+    }
+    
+    // хранятся только последние позиции, одно место - под текущую
+    EXPECT_EQ(history.GetUndoCount(), 3u);
+    EXPECT_FALSE(history.Undo(10, 4));
+    EXPECT_EQ(history.Undo(10, 3), 7);
+    EXPECT_EQ(history.Redo(3), 10);
+    EXPECT_EQ(history.Undo(10, 1), 9);
+    
+    history.Push(9);
+    EXPECT_EQ(history.GetRedoCount(), 0u);
+    EXPECT_EQ(history.GetUndoCount(), 3u);
+}
+
+TEST(EngineTest, ScoreAndMoveCount) {
+    vector<vector<EEngineTileType>> field = 
+                        {   {t2, t2, t4, t4},
+                            {t8, t0, t8, t0},
+                            {t0, t0, t0, t0},
+                            {t0, t0, t0, t0}    };
+    
+    TEngineWithHistory engine(field, 3);
+    EXPECT_EQ(engine.GetScore(), 0u);
+    
+    ASSERT_TRUE(engine.MakeTurn(ETurnDirection::LEFT));
+    EXPECT_EQ(engine.GetScore(), 4u + 8u + 16u);
+    EXPECT_EQ(engine.GetMoveCount(), 1u);
+    
+    EXPECT_FALSE(engine.MakeTurn(ETurnDirection::LEFT));
+    EXPECT_EQ(engine.GetMoveCount(), 1u) << "Move without changes must not be counted";
+    
+    engine.AfterTurn();
+    engine.Undo();
+    EXPECT_EQ(engine.GetScore(), 0u);
+    EXPECT_EQ(engine.GetMoveCount(), 0u);
+    
+    // для длинных строк очки считаются на месте, без таблицы
+    vector<vector<EEngineTileType>> field5(5, vector<EEngineTileType>(5, t0));
+    field5[2] = {t4, t4, t4, t4, t4};
+    TBasicEngine<5, 5> engine5(field5);
+    ASSERT_TRUE(engine5.ApplyMove(ETurnDirection::RIGHT));
+    EXPECT_EQ(engine5.GetScore(), 16u);
+    
+    // прирост счёта равен сумме значений новых тайлов из сведений для анимации
+    TEngine game(11);
+    mt19937 turns(11);
+    uint32_t expected = 0;
+    while (!game.IsEnd()) {
+        auto result = game.MakeTurn(static_cast<ETurnDirection>(turns() % 4));
+        if (result) {
+            for (const auto &new_tile : (*result).new_tiles) {
+                expected += 1u << (static_cast<int>(new_tile.type) - 1);
+            }
+            ASSERT_EQ(game.GetScore(), expected);
+            game.AfterTurn();
+        }
+    }
+    EXPECT_GT(game.GetMoveCount(), 0u);
+}
+
+TEST(EngineTest, BatchMatchesEngine) {
+    const uint64_t seed = 2024;
+    const size_t count = 64;
+    
+    TEngineBatch batch(count, seed);
+    batch.SetKeepPlaying(true);
+    
+    // партия 0 повторяется отдельным движком с теми же случайными числами
+    TRandom mirror(seed);
+    for (int k = 0; k < TILES_AT_START; k++) {
+        mirror.Next();
+    }
+    
+    auto to_field = [](const TBoard &board) {
+        vector<vector<EEngineTileType>> field(SIZE_OF_FIELD_X, vector<EEngineTileType>(SIZE_OF_FIELD_Y));
+        for (int x = 0; x < SIZE_OF_FIELD_X; x++) {
+            for (int y = 0; y < SIZE_OF_FIELD_Y; y++) {
+                field[x][y] = board(x, y);
+            }
+        }
+        return field;
+    };
+    TEngine engine(to_field(batch.GetBoard(0)));
+    engine.SetKeepPlaying(true);
+    
+    mt19937 turns(seed);
+    vector<ETurnDirection> actions(count);
+    vector<uint32_t> rewards;
+    vector<uint8_t> dones;
+    
+    size_t finished = 0;
+    bool engine_finished = false;
+    for (int step = 0; step < 2000; step++) {
+        for (auto &action : actions) {
+            action = static_cast<ETurnDirection>(turns() % 4);
+        }
+        
+        const uint32_t score_before = batch.GetScore(0);
+        batch.Step(actions, rewards, dones);
+        ASSERT_EQ(rewards.size(), count);
+        ASSERT_EQ(dones.size(), count);
+        
+        if (!engine_finished) {
+            const uint64_t word = mirror.Next();
+            if (engine.ApplyMove(actions[0])) {
+                engine.AfterTurn(word);
+            }
+            
+            if (dones[0]) {
+                EXPECT_TRUE(engine.IsLose());
+                EXPECT_EQ(engine.GetScore(), score_before + rewards[0]);
+                engine_finished = true;
+            } else {
+                ASSERT_EQ(engine.GetBoard(), batch.GetBoard(0)) << "step " << step;
+                ASSERT_EQ(engine.GetScore(), batch.GetScore(0));
+                ASSERT_EQ(engine.GetScore(), score_before + rewards[0]);
+            }
+        }
+        
+        for (size_t i = 0; i < count; i++) {
+            if (dones[i]) {
+                finished++;
+                // новая партия начинается с двух тайлов
+                ASSERT_EQ(batch.GetBoard(i).CountEmpty(), SIZE_OF_FIELD_X * SIZE_OF_FIELD_Y - TILES_AT_START);
+                ASSERT_EQ(batch.GetScore(i), 0u);
+            }
+        }
+    }
+    
+    EXPECT_TRUE(engine_finished);
+    EXPECT_GT(finished, count);
+    
+    vector<ETurnDirection> wrong(count + 1);
+    EXPECT_THROW(batch.Step(wrong, rewards, dones), runtime_error);
+}
+
+TEST(EngineTest, SimdMovesMatchScalar) {
+    // случайные поля, в том числе с тайлами, которые не объединяются (0xF), и число полей не кратное 8
+    const size_t count = 100003;
+    mt19937_64 generator(16);
+    
+    vector<TBoard> boards(count);
+    vector<ETurnDirection> turns(count);
+    for (size_t i = 0; i < count; i++) {
+        uint64_t cells = 0;
+        const int max_tile = i % 3 == 0 ? 16 : 5;
+        for (int k = 0; k < 16; k++) {
+            cells |= uint64_t(generator() % max_tile) << (4 * k);
+        }
+        boards[i] = TBoard(cells);
+        turns[i] = static_cast<ETurnDirection>(generator() % 4);
+    }
+    
+    vector<TBoard> expected(count), result(count);
+    vector<TMoveSummary> expected_summaries(count), summaries(count);
+    MoveBoardsScalar(boards.data(), turns.data(), expected.data(), expected_summaries.data(), count);
+    MoveBoards(boards.data(), turns.data(), result.data(), summaries.data(), count);
+    
+    for (size_t i = 0; i < count; i++) {
+        ASSERT_EQ(result[i], expected[i]) << hex << boards[i].GetRaw() << " " << static_cast<int>(turns[i]);
+        ASSERT_EQ(summaries[i].merges, expected_summaries[i].merges) << hex << boards[i].GetRaw();
+        ASSERT_EQ(summaries[i].score, expected_summaries[i].score) << hex << boards[i].GetRaw();
+        ASSERT_EQ(summaries[i].max_tile, expected_summaries[i].max_tile) << hex << boards[i].GetRaw();
+    }
+    
+    if (!HasAvx2Moves()) {
+        GTEST_SKIP() << "AVX2 is not available, only the scalar path was checked";
+    }
+}
+
 TEST(EngineTest, Lose) {
     vector<vector<EEngineTileType>> field = 
                         {   {t32, t16, t32, t0},
@@ -224,6 +774,142 @@ TEST(EngineTest, Lose) {
     
 }
 
+TEST(EngineTest, LoseOnlyWithoutMoves) {
+    vector<vector<EEngineTileType>> field = 
+                        {   {t2, t4, t2, t4},
+                            {t4, t2, t4, t2},
+                            {t2, t4, t2, t4},
+                            {t4, t2, t4, t8}    };
+    
+    TEngine engine(field);
+    EXPECT_TRUE(engine.IsLose());
+    
+    // единственные объединения - у края поля
+    field[0][0] = t4;
+    TEngine engine2(field);
+    EXPECT_FALSE(engine2.IsLose()) << "Merge on the edge was missed";
+}
+
+TEST(EngineTest, LoseMatchesBruteForce) {
+    // перебор всех заполненных полей из двух видов тайлов и случайные поля
+    auto can_move = [](const TBoard &board) {
+        for (auto turn : {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT}) {
+            if (TEngine::MoveBoard(board, turn) != board) {
+                return true;
+            }
+        }
+        return false;
+    };
+    
+    for (uint32_t mask = 0; mask < (1u << 16); mask++) {
+        uint64_t cells = 0;
+        for (int i = 0; i < 16; i++) {
+            cells |= uint64_t((mask >> i) & 1 ? 3 : 2) << (4 * i);
+        }
+        
+        TBoard board(cells);
+        ASSERT_EQ(board.HasEqualNeighbours(), can_move(board)) << hex << cells;
+    }
+    
+    mt19937_64 generator(8);
+    for (int k = 0; k < 100000; k++) {
+        uint64_t cells = 0;
+        for (int i = 0; i < 16; i++) {
+            cells |= uint64_t(1 + generator() % 6) << (4 * i);
+        }
+        
+        TBoard board(cells);
+        ASSERT_EQ(board.HasEqualNeighbours(), can_move(board)) << hex << cells;
+    }
+    
+    // счётчики пустых клеток и наибольшего тайла поддерживаются по ходу партии
+    for (uint64_t seed = 0; seed < 20; seed++) {
+        TEngine engine(seed);
+        mt19937 turns(seed);
+        
+        while (!engine.IsEnd()) {
+            if (engine.ApplyMove(static_cast<ETurnDirection>(turns() % 4))) {
+                engine.AfterTurn();
+                ASSERT_EQ(engine.IsLose(), !can_move(engine.GetBoard()));
+            }
+        }
+    }
+}
+
+TEST(EngineTest, OtherFieldSizes) {
+    static_assert(sizeof(TBasicBoard<3, 3>) == sizeof(uint64_t), "3x3 board must fit one machine word");
+    static_assert(sizeof(TBasicBoard<5, 5>) == 2 * sizeof(uint64_t), "5x5 board must take two words");
+    static_assert(sizeof(TBasicBoard<6, 6>) == 3 * sizeof(uint64_t), "6x6 board must take three words");
+    
+    vector<vector<EEngineTileType>> field(5, vector<EEngineTileType>(5, t0));
+    field[0] = {t2, t2, t4, t0, t4};
+    field[4] = {t0, t0, t0, t0, t2};
+    
+    TBasicEngine<5, 5> engine(field);
+    auto result = engine.MakeTurn(ETurnDirection::LEFT);
+    
+    ASSERT_TRUE(result);
+    EXPECT_EQ(engine(0, 0), t4);
+    EXPECT_EQ(engine(0, 1), t8);
+    EXPECT_EQ(engine(0, 2), t0);
+    EXPECT_EQ(engine(4, 0), t2);
+    EXPECT_EQ((*result).shifts.size(), 5u);
+    EXPECT_EQ((*result).new_tiles.size(), 2u);
+    
+    result = engine.MakeTurn(ETurnDirection::DOWN);
+    ASSERT_TRUE(result);
+    EXPECT_EQ(engine(3, 0), t4);
+    EXPECT_EQ(engine(4, 0), t2);
+    EXPECT_EQ(engine(4, 1), t8);
+    
+    // ядро строки из 3 клеток по таблице и посчитанное на месте совпадают
+    for (uint32_t row = 0; row < (1u << 12); row++) {
+        for (bool reverse_flag : {false, true}) {
+            const TWideRowMove wide = MakeRowMove<TWideRowMove>(row, 3, reverse_flag);
+            const TRowMove &narrow = reverse_flag ? ROW_MOVES_RIGHT_3[row] : ROW_MOVES_LEFT_3[row];
+            ASSERT_EQ(wide.row, narrow.row) << hex << row;
+            ASSERT_EQ(wide.score, narrow.score) << hex << row;
+        }
+        ASSERT_EQ((TRowKernel<3>::Legal(row)), (TRowKernel<3, false>::Legal(row))) << hex << row;
+    }
+}
+
+template <int X, int Y>
+void CheckRandomGames(int games) {
+    // маска ходов и проигрыш сверяются с перебором направлений по ходу случайных партий
+    typedef TBasicEngine<X, Y> TGameEngine;
+    
+    for (int seed = 0; seed < games; seed++) {
+        TGameEngine engine(seed);
+        mt19937 turns(seed);
+        
+        while (!engine.IsEnd()) {
+            const auto &board = engine.GetBoard();
+            
+            int expected = 0;
+            for (int turn = 0; turn < 4; turn++) {
+                if (TGameEngine::MoveBoard(board, static_cast<ETurnDirection>(turn)) != board) {
+                    expected |= 1 << turn;
+                }
+            }
+            ASSERT_EQ(engine.LegalMoves(), expected);
+            ASSERT_EQ(board.CountEmpty() == 0 && !board.HasEqualNeighbours(), expected == 0);
+            
+            if (engine.ApplyMove(static_cast<ETurnDirection>(turns() % 4))) {
+                engine.AfterTurn();
+            }
+        }
+        
+        EXPECT_EQ(engine.IsLose(), engine.LegalMoves() == 0 && !engine.IsWin());
+    }
+}
+
+TEST(EngineTest, OtherSizesMatchBruteForce) {
+    CheckRandomGames<3, 3>(200);
+    CheckRandomGames<5, 5>(20);
+    CheckRandomGames<6, 6>(5);
+}
+
 TEST (EngineTest, Win) {    
     vector<vector<EEngineTileType>> field = 
                         {   {t0, t2048, t0, t0},
@@ -238,6 +924,93 @@ TEST (EngineTest, Win) {
     EXPECT_TRUE(engine.IsEnd());
 }
 
+TEST (EngineTest, WinTileAndKeepPlaying) {
+    vector<vector<EEngineTileType>> field = 
+                        {   {t1024, t1024, t0, t0},
+                            {t0, t0, t0, t0},
+                            {t0, t0, t0, t0},
+                            {t0, t0, t0, t0}    };
+    
+    TEngine engine(field, 1);
+    engine.SetKeepPlaying(true);
+    engine.MakeTurn(ETurnDirection::LEFT);
+    engine.AfterTurn();
+    
+    EXPECT_TRUE(engine.IsWin());
+    EXPECT_FALSE(engine.IsEnd()) << "Game must go on after win in keep playing mode";
+    EXPECT_NE(engine.LegalMoves(), 0);
+    
+    // выигрыш пропадает, если выигрышный тайл поднять выше наибольшего на поле
+    engine.SetWinTile(EEngineTileType::TILE_4096);
+    EXPECT_FALSE(engine.IsWin());
+    
+    engine.SetKeepPlaying(false);
+    engine.SetWinTile(EEngineTileType::TILE_2048);
+    EXPECT_TRUE(engine.IsEnd());
+    
+    EXPECT_THROW(engine.SetWinTile(EEngineTileType::TILE_0), runtime_error);
+}
+
+TEST (EngineTest, TilesBeyond2048) {
+    auto t8192 = EEngineTileType::TILE_8192;
+    auto t16384 = EEngineTileType::TILE_16384;
+    vector<vector<EEngineTileType>> field = 
+                        {   {t8192, t8192, t0, t0},
+                            {t16384, t16384, t0, t0},
+                            {t0, t0, t0, t0},
+                            {t0, t0, t0, t0}    };
+    
+    TEngine engine(field, 1);
+    engine.SetWinTile(EEngineTileType::TILE_16384);
+    EXPECT_TRUE(engine.IsWin());
+    engine.SetKeepPlaying(true);
+    
+    auto result = engine.MakeTurn(ETurnDirection::RIGHT);
+    ASSERT_TRUE(result);
+    
+    // 8192 объединяются, 16384 - последний тайл, который помещается в клетку, и не объединяются
+    EXPECT_EQ(engine(0, 3), t16384);
+    EXPECT_EQ(engine(1, 2), t16384);
+    EXPECT_EQ(engine(1, 3), t16384);
+    EXPECT_EQ((*result).new_tiles.size(), 1u);
+    EXPECT_EQ((*result).new_tiles[0].type, t16384);
+}
+
+TEST (EngineTest, Pair16384IsLose) {
+    auto t16384 = EEngineTileType::TILE_16384;
+    vector<vector<EEngineTileType>> field = 
+                        {   {t16384, t16384, t2, t4},
+                            {t4, t2, t4, t2},
+                            {t2, t4, t2, t4},
+                            {t4, t2, t4, t2}    };
+    
+    // два тайла 16384 не объединяются: ходов нет, игра проиграна и в режиме продолжения
+    TEngine engine(field, 1);
+    engine.SetKeepPlaying(true);
+    EXPECT_EQ(engine.LegalMoves(), 0);
+    EXPECT_TRUE(engine.IsLose());
+    EXPECT_TRUE(engine.IsEnd());
+    EXPECT_FALSE(engine.GetBoard().HasEqualNeighbours());
+    EXPECT_FALSE(engine.GetBoard().Transpose().HasEqualNeighbours());
+    
+    // то же на поле из нескольких слов
+    vector<vector<EEngineTileType>> big_field(5, vector<EEngineTileType>(5));
+    for (int x = 0; x < 5; x++) {
+        for (int y = 0; y < 5; y++) {
+            big_field[x][y] = (x + y) % 2 ? t4 : t2;
+        }
+    }
+    big_field[0][0] = t16384;
+    big_field[1][0] = t16384;
+    
+    TBasicEngine<5, 5> big_engine(big_field);
+    big_engine.SetKeepPlaying(true);
+    EXPECT_EQ(big_engine.LegalMoves(), 0);
+    EXPECT_TRUE(big_engine.IsLose());
+    EXPECT_FALSE(big_engine.GetBoard().HasEqualNeighbours());
+    EXPECT_FALSE(big_engine.GetBoard().Transpose().HasEqualNeighbours());
+}
+
 TEST (EngineTest, MiddleGame) {
     
     vector<vector<EEngineTileType>> field = 
@@ -281,6 +1054,705 @@ TEST (EngineTest, ExceptionAfterEnd) {
     
 }
 
+TEST(EngineTest, Symmetry) {
+    // координаты, в которые переходит клетка (x, y), по описанию EBoardSymmetry
+    const vector<pair<EBoardSymmetry, function<pair<int, int>(int, int)>>> cases = {
+        {EBoardSymmetry::IDENTITY, [](int x, int y) { return make_pair(x, y); }},
+        {EBoardSymmetry::MIRROR_ROWS, [](int x, int y) { return make_pair(x, 3 - y); }},
+        {EBoardSymmetry::MIRROR_COLUMNS, [](int x, int y) { return make_pair(3 - x, y); }},
+        {EBoardSymmetry::ROTATE_180, [](int x, int y) { return make_pair(3 - x, 3 - y); }},
+        {EBoardSymmetry::TRANSPOSE, [](int x, int y) { return make_pair(y, x); }},
+        {EBoardSymmetry::ROTATE_90, [](int x, int y) { return make_pair(y, 3 - x); }},
+        {EBoardSymmetry::ROTATE_270, [](int x, int y) { return make_pair(3 - y, x); }},
+        {EBoardSymmetry::ANTI_TRANSPOSE, [](int x, int y) { return make_pair(3 - y, 3 - x); }}
+    };
+    
+    mt19937_64 generator(22);
+    for (int i = 0; i < 1000; i++) {
+        const TBoard board(generator());
+    
+        for (const auto &c : cases) {
+            const TBoard image = ApplySymmetry(board, c.first);
+            for (int x = 0; x < 4; x++) {
+                for (int y = 0; y < 4; y++) {
+                    const auto target = c.second(x, y);
+                    ASSERT_EQ(image(target.first, target.second), board(x, y));
+                }
+            }
+    
+            ASSERT_EQ(ApplySymmetry(image, InverseSymmetry(c.first)), board);
+    
+            // ход и преобразование перестановочны
+            for (ETurnDirection turn : {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT}) {
+                ASSERT_EQ(TEngine::MoveBoard(image, ApplySymmetry(turn, c.first)), ApplySymmetry(TEngine::MoveBoard(board, turn), c.first));
+            }
+        }
+    
+        // все восемь образов дают одно каноническое поле, и оно не больше любого из них
+        const auto canonical = Canonicalize(board);
+        ASSERT_EQ(ApplySymmetry(board, canonical.second), canonical.first);
+        for (const auto &c : cases) {
+            const TBoard image = ApplySymmetry(board, c.first);
+            ASSERT_EQ(Canonicalize(image).first, canonical.first);
+            ASSERT_LE(canonical.first.GetRaw(), image.GetRaw());
+        }
+    }
+}
+
+TEST(SelfPlayTest, ResultsDoNotDependOnThreads) {
+    TSelfPlaySettings settings;
+    settings.games = 40;
+    settings.seed = 7;
+    
+    for (const string &name : {"random", "greedy"}) {
+        settings.threads = 1;
+        const TSelfPlayReport single = TSelfPlay::Run(settings, GetPolicyFactory(name));
+        settings.threads = 3;
+        const TSelfPlayReport many = TSelfPlay::Run(settings, GetPolicyFactory(name));
+    
+        ASSERT_EQ(single.games.size(), 40u);
+        ASSERT_EQ(many.games.size(), 40u);
+        for (size_t i = 0; i < single.games.size(); i++) {
+            ASSERT_EQ(single.games[i].score, many.games[i].score);
+            ASSERT_EQ(single.games[i].move_count, many.games[i].move_count);
+            ASSERT_EQ(single.games[i].max_tile, many.games[i].max_tile);
+            ASSERT_GT(single.games[i].move_count, 0u);
+        }
+    
+        const vector<int> counts = single.GetMaxTileCounts();
+        ASSERT_EQ(accumulate(counts.begin(), counts.end(), 0), 40);
+        ASSERT_LE(single.GetScorePercentile(0.5), single.GetScorePercentile(0.9));
+        ASSERT_LE(single.GetScorePercentile(0.9), single.GetScorePercentile(1));
+    }
+}
+
+TEST(SelfPlayTest, ScorePercentile) {
+    TSelfPlayReport report;
+    for (uint32_t score : {70, 10, 100, 40, 20, 90, 30, 60, 50, 80}) {
+        TGameResult game;
+        game.score = score;
+        report.games.push_back(game);
+    }
+    
+    // ближайший ранг на 10 партиях: p90 - девятое значение, а не наибольшее
+    ASSERT_EQ(report.GetScorePercentile(0), 10u);
+    ASSERT_EQ(report.GetScorePercentile(0.1), 10u);
+    ASSERT_EQ(report.GetScorePercentile(0.15), 20u);
+    ASSERT_EQ(report.GetScorePercentile(0.5), 50u);
+    ASSERT_EQ(report.GetScorePercentile(0.9), 90u);
+    ASSERT_EQ(report.GetScorePercentile(0.99), 100u);
+    ASSERT_EQ(report.GetScorePercentile(1), 100u);
+    
+    ASSERT_EQ(TSelfPlayReport().GetScorePercentile(0.5), 0u);
+}
+
+TEST(SelfPlayTest, GreedyBeatsRandom) {
+    TSelfPlaySettings settings;
+    settings.games = 50;
+    
+    const TSelfPlayReport random = TSelfPlay::Run(settings, GetPolicyFactory("random"));
+    const TSelfPlayReport greedy = TSelfPlay::Run(settings, GetPolicyFactory("greedy"));
+    ASSERT_GT(greedy.GetScorePercentile(0.5), random.GetScorePercentile(0.5));
+}
+
+TEST(SelfPlayTest, PolicyErrors) {
+    ASSERT_THROW(GetPolicyFactory("no such policy"), runtime_error);
+    
+    // политика, делающая ход, который не меняет поле, не должна зацикливать партию
+    RegisterPolicy("stuck", []() {
+        return TPolicy([](const TEngine &engine, TRandom &) {
+            for (ETurnDirection turn : {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT}) {
+                if (!(engine.LegalMoves() & (1 << static_cast<int>(turn)))) {
+                    return turn;
+                }
+            }
+            return ETurnDirection::UP;
+        });
+    });
+    
+    TSelfPlaySettings settings;
+    settings.games = 5;
+    settings.threads = 2;
+    ASSERT_THROW(TSelfPlay::Run(settings, GetPolicyFactory("stuck")), runtime_error);
+}
+
+TEST(AiTest, ThreadPoolNestedGroups) {
+    TThreadPool pool(3);
+    ASSERT_EQ(pool.GetThreadCount(), 3);
+    ASSERT_EQ(pool.GetWorkerIndex(), -1);
+    
+    // внешние задачи ждут вложенные: без помощи в Wait три потока заняли бы все ожиданием
+    atomic<int> sum(0);
+    TTaskGroup outer(pool);
+    for (int i = 0; i < 8; i++) {
+        outer.Run([&pool, &sum]() {
+            ASSERT_GE(pool.GetWorkerIndex(), 0);
+            TTaskGroup inner(pool);
+            for (int j = 0; j < 100; j++) {
+                inner.Run([&sum, j]() {
+                    sum += j;
+                });
+            }
+            inner.Wait();
+        });
+    }
+    outer.Wait();
+    ASSERT_EQ(sum, 8 * 4950);
+    
+    TTaskGroup failing(pool);
+    failing.Run([]() {
+        throw runtime_error("task failed");
+    });
+    ASSERT_THROW(failing.Wait(), runtime_error);
+}
+
+TEST(AiTest, RolloutDoesNotDependOnThreads) {
+    TEngine engine({
+        {t0, t2, t0, t0},
+        {t4, t0, t8, t0},
+        {t0, t16, t0, t2},
+        {t0, t0, t4, t0}
+    }, 5);
+    
+    TRolloutSettings settings;
+    settings.rollouts_per_move = 100;
+    settings.chunk_size = 8;
+    settings.seed = 11;
+    
+    TThreadPool single_pool(1), many_pool(4);
+    TRollout single(single_pool), many(many_pool);
+    
+    const TRolloutResult a = single.Evaluate(engine, settings);
+    const TRolloutResult b = many.Evaluate(engine, settings);
+    
+    ASSERT_TRUE(a.found_flag);
+    ASSERT_FALSE(a.deadline_flag);
+    ASSERT_EQ(a.total_rollouts, 400u);
+    ASSERT_EQ(a.best_move, b.best_move);
+    for (int turn = 0; turn < 4; turn++) {
+        ASSERT_EQ(a.rollout_counts[turn], 100u);
+        ASSERT_EQ(a.rollout_counts[turn], b.rollout_counts[turn]);
+        ASSERT_DOUBLE_EQ(a.mean_scores[turn], b.mean_scores[turn]);
+        ASSERT_GT(a.mean_scores[turn], 0);
+    }
+}
+
+TEST(AiTest, RolloutLegalMovesAndDeadline) {
+    // влево и вверх ход не меняет поле
+    TEngine engine({
+        {t2, t4, t2, t4},
+        {t4, t2, t4, t2},
+        {t2, t4, t2, t0},
+        {t4, t2, t0, t0}
+    }, 3);
+    
+    TThreadPool pool(2);
+    TRollout rollout(pool);
+    
+    TRolloutSettings settings;
+    settings.rollouts_per_move = 50;
+    const TRolloutResult result = rollout.Evaluate(engine, settings);
+    ASSERT_TRUE(result.best_move == ETurnDirection::RIGHT || result.best_move == ETurnDirection::DOWN);
+    ASSERT_EQ(result.rollout_counts[static_cast<int>(ETurnDirection::LEFT)], 0u);
+    ASSERT_EQ(result.rollout_counts[static_cast<int>(ETurnDirection::UP)], 0u);
+    
+    // время уже вышло: партий нет, но ход всё равно возможный
+    const TRolloutResult late = rollout.Evaluate(engine, settings, TRollout::TClock::now());
+    ASSERT_TRUE(late.deadline_flag);
+    ASSERT_EQ(late.total_rollouts, 0u);
+    ASSERT_TRUE(engine.LegalMoves() & (1 << static_cast<int>(late.best_move)));
+    
+    TEngine lost({
+        {t2, t4, t2, t4},
+        {t4, t2, t4, t2},
+        {t2, t4, t2, t4},
+        {t4, t2, t4, t2}
+    }, 3);
+    ASSERT_FALSE(rollout.Evaluate(lost, settings).found_flag);
+}
+
+TEST(AiTest, HeuristicTable) {
+    mt19937 generator(20);
+    for (int i = 0; i < 1000; i++) {
+        const uint32_t row = generator() % ROW_COUNT;
+        ASSERT_EQ(HEURISTIC_ROWS[row], MakeRowHeuristic(row));
+    }
+    
+    // монотонная строка лучше той же строки с крупным тайлом посередине
+    ASSERT_GT(HEURISTIC_ROWS[0x4321], HEURISTIC_ROWS[0x3421]);
+    // пустые клетки в плюс
+    ASSERT_GT(HEURISTIC_ROWS[0x0021], HEURISTIC_ROWS[0x4321]);
+    // возможные объединения в плюс
+    ASSERT_GT(HEURISTIC_ROWS[0x3321], HEURISTIC_ROWS[0x4321]);
+}
+
+TEST(AiTest, SolverDepthOneIsHeuristic) {
+    const TBoard board(std::vector<std::vector<EEngineTileType>>{
+        {t2, t4, t0, t0},
+        {t2, t0, t8, t0},
+        {t0, t16, t0, t2},
+        {t0, t0, t4, t0}
+    });
+    
+    TSolver solver;
+    TSolverBudget budget;
+    budget.depth = 1;
+    const TSolverResult result = solver.BestMove(board, budget);
+    
+    ASSERT_TRUE(result.found_flag);
+    float best = -numeric_limits<float>::max();
+    for (ETurnDirection turn : {ETurnDirection::UP, ETurnDirection::RIGHT, ETurnDirection::DOWN, ETurnDirection::LEFT}) {
+        const float value = EvaluateBoard(TEngine::MoveBoard(board, turn));
+        ASSERT_EQ(result.values[static_cast<int>(turn)], value);
+        best = max(best, value);
+    }
+    ASSERT_EQ(result.values[static_cast<int>(result.best_move)], best);
+}
+
+TEST(AiTest, SolverPlaysLegalMoves) {
+    // влево и вверх ход не меняет поле
+    TEngine engine({
+        {t2, t4, t2, t4},
+        {t4, t2, t4, t2},
+        {t2, t4, t2, t0},
+        {t4, t2, t0, t0}
+    }, 3);
+    
+    TSolver solver;
+    const TSolverResult stuck = solver.BestMove(engine, TSolverBudget());
+    ASSERT_TRUE(stuck.found_flag);
+    ASSERT_EQ(stuck.values[static_cast<int>(ETurnDirection::LEFT)], 0);
+    ASSERT_EQ(stuck.values[static_cast<int>(ETurnDirection::UP)], 0);
+    ASSERT_TRUE(stuck.best_move == ETurnDirection::RIGHT || stuck.best_move == ETurnDirection::DOWN);
+    
+    // партия целиком: ни одного хода, не меняющего поле, и результат лучше жадной политики
+    TSolverBudget budget;
+    budget.depth = 2;
+    TEngine game(17);
+    while (!game.IsEnd()) {
+        const TSolverResult result = solver.BestMove(game, budget);
+        ASSERT_TRUE(result.found_flag);
+        ASSERT_GT(result.nodes, 0u);
+        ASSERT_TRUE(game.ApplyMove(result.best_move));
+        game.AfterTurn();
+    }
+    
+    TSelfPlaySettings settings;
+    settings.games = 1;
+    settings.seed = 17;
+    settings.keep_playing_flag = false;
+    const TSelfPlayReport greedy = TSelfPlay::Run(settings, GetPolicyFactory("greedy"));
+    ASSERT_GT(game.GetScore(), greedy.games[0].score);
+    ASSERT_FALSE(solver.BestMove(game, budget).found_flag);
+}
+
+TEST(AiTest, SolverAvoidsCertainLoss) {
+    // крупные тайлы не по порядку: оценка живых полей здесь намного ниже нуля
+    const TBoard board(0x15d72c6a3b2d0e28ULL);
+    
+    // после хода вправо любое появление тайла проигрывает, вверх - нет
+    const TBoard right = TEngine::MoveBoard(board, ETurnDirection::RIGHT);
+    ASSERT_NE(right, board);
+    ASSERT_EQ(right.CountEmpty(), 1);
+    for (EEngineTileType tile : {t2, t4}) {
+        const int cell = right.FindEmpty(0);
+        TBoard spawned = right;
+        spawned.Set(cell / 4, cell % 4, tile);
+        ASSERT_EQ(TEngine::LegalMoves(spawned), 0);
+    }
+    
+    TSolver solver;
+    TSolverBudget budget;
+    budget.depth = 2;
+    const TSolverResult result = solver.BestMove(board, budget);
+    
+    ASSERT_TRUE(result.found_flag);
+    ASSERT_NE(result.best_move, ETurnDirection::RIGHT);
+    ASSERT_EQ(result.values[static_cast<int>(ETurnDirection::RIGHT)], HEURISTIC_LOST_VALUE);
+    ASSERT_LT(HEURISTIC_LOST_VALUE, result.values[static_cast<int>(result.best_move)]);
+    ASSERT_LT(HEURISTIC_LOST_VALUE, 8 * *min_element(HEURISTIC_ROWS.begin(), HEURISTIC_ROWS.end()));
+}
+
+TEST(AiTest, TranspositionTableProbeStore) {
+    TTranspositionTable table(1);
+    ASSERT_EQ(table.size(), (1u << 20) / 16);
+    ASSERT_GE(table.GetSizeBytes(), table.size() * 16);
+    
+    const TBoard board(0x0000000000012345ULL);
+    TTranspositionEntry entry;
+    ASSERT_FALSE(table.Probe(board, ETranspositionNode::MOVE, entry));
+    
+    entry.value = 12.5f;
+    entry.depth = 3;
+    entry.move_flag = true;
+    entry.best_move = ETurnDirection::LEFT;
+    table.Store(board, ETranspositionNode::MOVE, entry);
+    
+    // узел другого типа с тем же полем - другая запись
+    TTranspositionEntry found;
+    ASSERT_FALSE(table.Probe(board, ETranspositionNode::CHANCE, found));
+    ASSERT_TRUE(table.Probe(board, ETranspositionNode::MOVE, found));
+    ASSERT_EQ(found.value, 12.5f);
+    ASSERT_EQ(found.depth, 3);
+    ASSERT_TRUE(found.move_flag);
+    ASSERT_EQ(found.best_move, ETurnDirection::LEFT);
+    
+    // менее глубокая оценка той же позиции не заменяет более глубокую
+    TTranspositionEntry shallow;
+    shallow.value = 1;
+    shallow.depth = 2;
+    table.Store(board, ETranspositionNode::MOVE, shallow);
+    ASSERT_TRUE(table.Probe(board, ETranspositionNode::MOVE, found));
+    ASSERT_EQ(found.depth, 3);
+    
+    // пустое поле - тоже ключ
+    ASSERT_FALSE(table.Probe(TBoard(), ETranspositionNode::CHANCE, found));
+    table.Store(TBoard(), ETranspositionNode::CHANCE, shallow);
+    ASSERT_TRUE(table.Probe(TBoard(), ETranspositionNode::CHANCE, found));
+    
+    const TTranspositionStats stats = table.GetStats();
+    ASSERT_EQ(stats.probes, 6u);
+    ASSERT_EQ(stats.hits, 3u);
+    ASSERT_EQ(stats.stores, 2u);
+    
+    table.clear();
+    ASSERT_FALSE(table.Probe(board, ETranspositionNode::MOVE, found));
+    ASSERT_EQ(table.GetStats().probes, 1u);
+}
+
+TEST(AiTest, TranspositionTableConcurrent) {
+    // маленькая таблица и много ключей: потоки постоянно пишут одни и те же ячейки
+    // значение выводится из ключа, поэтому любая рваная запись была бы видна
+    TTranspositionTable table(1);
+    atomic<int> wrong(0);
+    
+    vector<thread> threads;
+    for (int t = 0; t < 4; t++) {
+        threads.emplace_back([&table, &wrong, t]() {
+            mt19937_64 generator(t);
+            for (int i = 0; i < 200000; i++) {
+                const uint64_t key = generator() % (1 << 20) * 0x9E3779B97F4A7C15ULL;
+                TTranspositionEntry entry;
+                if (table.Probe(TBoard(key), ETranspositionNode::CHANCE, entry)) {
+                    wrong += entry.value != float(key >> 40) || entry.depth != int(key >> 58);
+                } else {
+                    entry.value = float(key >> 40);
+                    entry.depth = int(key >> 58);
+                    table.Store(TBoard(key), ETranspositionNode::CHANCE, entry);
+                }
+            }
+        });
+    }
+    for (thread &t : threads) {
+        t.join();
+    }
+    
+    ASSERT_EQ(wrong, 0);
+    const TTranspositionStats stats = table.GetStats();
+    ASSERT_EQ(stats.probes, 800000u);
+    ASSERT_GT(stats.hits, 0u);
+    ASSERT_GT(stats.collisions, 0u);
+    ASSERT_GT(stats.GetHitRate(), 0);
+}
+
+TEST(AiTest, SolverReusesTranspositionTable) {
+    const TBoard board(std::vector<std::vector<EEngineTileType>>{
+        {t2, t4, t0, t0},
+        {t2, t0, t8, t0},
+        {t0, t16, t0, t2},
+        {t0, t0, t4, t0}
+    });
+    
+    TTranspositionTable table(4);
+    TSolver first(table), second(table);
+    
+    TSolverBudget budget;
+    const TSolverResult cold = first.BestMove(board, budget);
+    ASSERT_GT(cold.transposition_stats.hits, 0u); // ходы в другом порядке приводят к тем же полям
+    ASSERT_GT(cold.transposition_stats.stores, 0u);
+    
+    // второй решатель с общей таблицей находит узлы, посчитанные первым
+    const TSolverResult warm = second.BestMove(board, budget);
+    ASSERT_EQ(warm.best_move, cold.best_move);
+    ASSERT_LT(warm.nodes, cold.nodes);
+    
+    TTranspositionEntry entry;
+    ASSERT_TRUE(table.Probe(board, ETranspositionNode::MOVE, entry));
+    ASSERT_EQ(entry.best_move, cold.best_move);
+    ASSERT_EQ(entry.depth, budget.depth);
+}
+
+TEST(AiTest, SolverWithSymmetricTable) {
+    const TBoard board(std::vector<std::vector<EEngineTileType>>{
+        {t2, t4, t0, t0},
+        {t2, t0, t8, t0},
+        {t0, t16, t0, t2},
+        {t0, t0, t4, t0}
+    });
+    
+    TSolver solver;
+    TSolverBudget budget;
+    budget.symmetry_flag = true;
+    
+    // первый поиск заполняет таблицу, второй по повёрнутому полю находит в ней те же узлы
+    const TSolverResult direct = solver.BestMove(board, budget);
+    ASSERT_TRUE(direct.found_flag);
+    
+    const TBoard mirrored = ApplySymmetry(board, EBoardSymmetry::ROTATE_90);
+    const TSolverResult rotated = solver.BestMove(mirrored, budget);
+    ASSERT_EQ(rotated.best_move, ApplySymmetry(direct.best_move, EBoardSymmetry::ROTATE_90));
+    ASSERT_LT(rotated.nodes, direct.nodes);
+}
+
+TEST(AiTest, ParallelSolverMatchesSolver) {
+    // на глубине 2 таблица не влияет на оценки, поэтому порядок задач в пуле не важен и оценки совпадают точно
+    TSolverBudget budget;
+    budget.depth = 2;
+    
+    TThreadPool pool(3);
+    TTranspositionTable table(4);
+    TParallelSolver parallel(pool, table);
+    TSolver solver;
+    
+    TEngine engine(23);
+    for (int i = 0; i < 30 && !engine.IsEnd(); i++) {
+        const TSolverResult expected = solver.BestMove(engine, budget);
+        const TSolverResult result = parallel.BestMove(engine, budget);
+    
+        ASSERT_TRUE(result.found_flag);
+        ASSERT_TRUE(result.complete_flag);
+        ASSERT_EQ(result.best_move, expected.best_move);
+        ASSERT_EQ(result.nodes, expected.nodes);
+        for (int turn = 0; turn < 4; turn++) {
+            ASSERT_EQ(result.values[turn], expected.values[turn]);
+        }
+    
+        engine.ApplyMove(result.best_move);
+        engine.AfterTurn();
+    }
+    
+    budget.depth = 3;
+    const TSolverResult deep = parallel.BestMove(engine, budget);
+    ASSERT_TRUE(deep.complete_flag);
+    ASSERT_TRUE(engine.LegalMoves() & (1 << static_cast<int>(deep.best_move)));
+}
+
+TEST(AiTest, SolverStopsAtDeadline) {
+    const TBoard board(std::vector<std::vector<EEngineTileType>>{
+        {t2, t4, t0, t0},
+        {t0, t0, t8, t0},
+        {t0, t16, t0, t0},
+        {t0, t0, t0, t0}
+    });
+    
+    TThreadPool pool(2);
+    TTranspositionTable table(4);
+    TParallelSolver parallel(pool, table);
+    TSolver solver(table);
+    
+    // время уже вышло: ход всё равно возможный, но поиск не досчитан
+    TSolverBudget late;
+    late.depth = 6;
+    late.deadline = chrono::steady_clock::now();
+    
+    for (TSolverResult result : {solver.BestMove(board, late), parallel.BestMove(board, late)}) {
+        ASSERT_TRUE(result.found_flag);
+        ASSERT_FALSE(result.complete_flag);
+        ASSERT_TRUE(TEngine::LegalMoves(board) & (1 << static_cast<int>(result.best_move)));
+    }
+    
+    // отмена флагом
+    atomic<bool> cancel(true);
+    TSolverBudget cancelled;
+    cancelled.depth = 6;
+    cancelled.cancel_flag = &cancel;
+    ASSERT_FALSE(parallel.BestMove(board, cancelled).complete_flag);
+    ASSERT_FALSE(solver.BestMove(board, cancelled).complete_flag);
+    
+    // прерванный посреди дерева поиск не оставляет в таблице неверных оценок (прерванные узлы вернули бы 0);
+    // точного равенства нет, потому что досчитанные более глубокие узлы законно используются мельче
+    TSolverBudget deep;
+    deep.depth = 5;
+    deep.deadline = chrono::steady_clock::now() + chrono::milliseconds(5);
+    parallel.BestMove(board, deep);
+    
+    TSolverBudget shallow;
+    shallow.depth = 2;
+    TSolver clean;
+    const TSolverResult expected = clean.BestMove(board, shallow);
+    const TSolverResult result = solver.BestMove(board, shallow);
+    for (int turn = 0; turn < 4; turn++) {
+        ASSERT_NEAR(result.values[turn], expected.values[turn], expected.values[turn] * 1e-3);
+    }
+}
+
+TEST(AiTest, HintIterativeDeepening) {
+    const TBoard board(std::vector<std::vector<EEngineTileType>>{
+        {t2, t4, t0, t0},
+        {t2, t0, t8, t0},
+        {t0, t16, t0, t2},
+        {t0, t0, t4, t0}
+    });
+    
+    THintService service(2, 4);
+    
+    // времени с запасом: досчитываются все глубины
+    THintSettings settings;
+    settings.budget = chrono::seconds(10);
+    settings.max_depth = 3;
+    
+    const THint hint = service.GetHint(board, settings);
+    ASSERT_TRUE(hint.found_flag);
+    ASSERT_EQ(hint.depth, 3);
+    ASSERT_EQ(hint.iterations.size(), 3u);
+    for (size_t i = 0; i < hint.iterations.size(); i++) {
+        ASSERT_EQ(hint.iterations[i].depth, int(i) + 1);
+        ASSERT_TRUE(hint.iterations[i].complete_flag);
+        ASSERT_GT(hint.iterations[i].nodes, 0u);
+    }
+    ASSERT_EQ(hint.best_move, hint.iterations.back().best_move);
+    
+    // лучший ход последней глубины лежит в таблице и при следующем поиске идёт первым
+    TSolver solver(service.GetTable());
+    ASSERT_EQ(solver.OrderMoves(board, TSolverBudget())[0], hint.best_move);
+    
+    TEngine lost({
+        {t2, t4, t2, t4},
+        {t4, t2, t4, t2},
+        {t2, t4, t2, t4},
+        {t4, t2, t4, t2}
+    }, 3);
+    ASSERT_FALSE(service.GetHint(lost, settings).found_flag);
+}
+
+TEST(AiTest, HintLatencyBudget) {
+    const TBoard board(std::vector<std::vector<EEngineTileType>>{
+        {t2, t0, t0, t0},
+        {t0, t0, t8, t0},
+        {t0, t4, t0, t0},
+        {t0, t0, t0, t0}
+    });
+    
+    THintService service(2, 4);
+    
+    // глубина 20 не успеет никогда: ответ - с последней досчитанной глубины, время - в пределах бюджета
+    THintSettings settings;
+    settings.budget = chrono::milliseconds(5);
+    settings.max_depth = 20;
+    
+    const THint hint = service.GetHint(board, settings);
+    ASSERT_TRUE(hint.found_flag);
+    ASSERT_GE(hint.depth, 1);
+    ASSERT_LT(hint.depth, 20);
+    ASSERT_LT(hint.seconds, 0.05); // проверка времени раз в несколько сотен узлов, даже в отладочной сборке
+    ASSERT_TRUE(TEngine::LegalMoves(board) & (1 << static_cast<int>(hint.best_move)));
+    
+    // отменённая подсказка возвращается сразу, ход всё равно возможный
+    atomic<bool> cancel(true);
+    settings.budget = chrono::seconds(10);
+    const THint cancelled = service.GetHint(board, settings, &cancel);
+    ASSERT_TRUE(cancelled.found_flag);
+    ASSERT_LE(cancelled.depth, 1);
+    ASSERT_LT(cancelled.seconds, 0.05);
+    ASSERT_TRUE(TEngine::LegalMoves(board) & (1 << static_cast<int>(cancelled.best_move)));
+}
+
+TEST(AiTest, HintWaitsNoLongerThanBudget) {
+    const TBoard board(std::vector<std::vector<EEngineTileType>>{
+        {t2, t0, t0, t0},
+        {t0, t0, t8, t0},
+        {t0, t4, t0, t0},
+        {t0, t0, t0, t0}
+    });
+    
+    TThreadPool pool(2);
+    TTranspositionTable table(4);
+    THintService service(pool, table);
+    
+    // первый вызов занимает сервис надолго
+    THintSettings long_settings;
+    long_settings.budget = chrono::seconds(60);
+    long_settings.max_depth = 20;
+    atomic<bool> cancel(false);
+    thread first([&]() {
+        service.GetHint(board, long_settings, &cancel);
+    });
+    this_thread::sleep_for(chrono::milliseconds(20));
+    
+    // второй не ждёт дольше своего бюджета и отвечает возможным ходом без перебора
+    THintSettings settings;
+    settings.budget = chrono::milliseconds(5);
+    const THint hint = service.GetHint(board, settings);
+    cancel = true;
+    first.join();
+    
+    ASSERT_TRUE(hint.found_flag);
+    ASSERT_EQ(hint.depth, 0);
+    ASSERT_TRUE(hint.iterations.empty());
+    ASSERT_LT(hint.seconds, 0.05);
+    ASSERT_TRUE(TEngine::LegalMoves(board) & (1 << static_cast<int>(hint.best_move)));
+}
+
+TEST(AiTest, BackgroundHint) {
+    const TBoard first(std::vector<std::vector<EEngineTileType>>{
+        {t2, t0, t0, t0},
+        {t0, t0, t8, t0},
+        {t0, t4, t0, t0},
+        {t0, t0, t0, t0}
+    });
+    const TBoard second(std::vector<std::vector<EEngineTileType>>{
+        {t2, t4, t0, t0},
+        {t2, t0, t8, t0},
+        {t0, t16, t0, t2},
+        {t0, t0, t4, t0}
+    });
+    
+    TBackgroundHint hint(1, 4);
+    
+    // первая позиция считалась бы минуту, но досчитанные глубины видны сразу
+    THintSettings long_settings;
+    long_settings.budget = chrono::seconds(60);
+    long_settings.max_depth = 20;
+    hint.Request(first, long_settings);
+    this_thread::sleep_for(chrono::milliseconds(20));
+    const optional<THint> early = hint.GetCached(first);
+    ASSERT_TRUE(early);
+    ASSERT_TRUE(early->found_flag);
+    ASSERT_GE(early->depth, 1);
+    ASSERT_LT(early->depth, 20);
+    ASSERT_GE(hint.GetHintNow(first).depth, early->depth);
+    
+    // новая позиция прерывает перебор старой, её неглубокая подсказка готова почти сразу
+    THintSettings short_settings;
+    short_settings.budget = chrono::seconds(60);
+    short_settings.max_depth = 2;
+    const auto start = chrono::steady_clock::now();
+    hint.Request(second, short_settings);
+    
+    optional<THint> cached;
+    while ((!cached || cached->depth < 2) && chrono::steady_clock::now() - start < chrono::seconds(10)) {
+        this_thread::sleep_for(chrono::microseconds(100));
+        cached = hint.GetCached(second);
+    }
+    ASSERT_TRUE(cached);
+    ASSERT_LT(chrono::duration<double>(chrono::steady_clock::now() - start).count(), 1.0);
+    ASSERT_TRUE(cached->found_flag);
+    ASSERT_EQ(cached->depth, 2);
+    
+    // подсказка хранится для одной позиции; готовая не пересчитывается
+    ASSERT_FALSE(hint.GetCached(first));
+    hint.Request(second, short_settings);
+    ASSERT_TRUE(hint.GetCached(second));
+    
+    // позиция, которую не запрашивали: ответ сразу, по оценке поля
+    const THint now = hint.GetHintNow(TEngine::MoveBoard(second, ETurnDirection::UP));
+    ASSERT_TRUE(now.found_flag);
+    ASSERT_EQ(now.depth, 0);
+    
+    // поток останавливается посреди долгого перебора без ожидания бюджета
+    hint.Request(first, long_settings);
+}
+
 
 class ViewTest : public ::testing::Test {
     public:
@@ -330,6 +1802,19 @@ TEST_F (ViewTest, BasicTest) {
 }
 
 
+TEST_F (ViewTest, TilesBeyond2048) {
+    vector<vector<EEngineTileType>> big_field(SIZE_OF_FIELD_X, vector<EEngineTileType>(SIZE_OF_FIELD_Y, t0));
+    big_field[0][0] = EEngineTileType::TILE_4096;
+    big_field[2][1] = EEngineTileType::TILE_16384;
+    TEngine big_engine(big_field);
+    
+    EXPECT_CALL(mockdisplay, DrawTile(0, 0, ETileType::TILE_4096, 1.0f));
+    EXPECT_CALL(mockdisplay, DrawTile(2, 1, ETileType::TILE_16384, 1.0f));
+    
+    view.Render(big_engine);
+}
+
+
 TEST_F (ViewTest, WinLoseScreens) {
     EXPECT_CALL(mockdisplay, DrawWinMessage);
     view.WinScreen(engine);
@@ -362,6 +1847,6 @@ TEST (ViewTestNotBasic, Animation) {
     ASSERT_TRUE(result);
     
     engine.AfterTurn();
-    view.Animate((*result).first, (*result).second, engine);
+    view.Animate(*result, engine);
 
 }
\ No newline at end of file